@@ -0,0 +1,56 @@
+#include "AssetLoader.h"
+
+#include "Profile.h"
+
+AssetLoader::~AssetLoader() {
+    std::unique_lock<std::mutex> lock(m_InFlightMutex);
+    m_InFlightDone.wait(lock, [this]() { return m_InFlight == 0; });
+}
+
+std::future<ImageData> AssetLoader::LoadImageAsync(const std::string& file) {
+    auto decoded = std::make_shared<std::promise<ImageData>>();
+    std::future<ImageData> result = decoded->get_future();
+    RunOnPool([file, decoded]() { decoded->set_value(ImageData::Load(file)); });
+    return result;
+}
+
+std::shared_future<TexturePtr> AssetLoader::LoadTextureAsync(const std::string& file) {
+    auto uploaded = std::make_shared<std::promise<TexturePtr>>();
+    std::shared_future<TexturePtr> result = uploaded->get_future().share();
+    RunOnPool([this, file, uploaded]() {
+        ImageData image = ImageData::Load(file);
+        EnqueueUploads({[image, file, uploaded]() { uploaded->set_value(std::make_shared<Texture>(image, file)); }});
+    });
+    return result;
+}
+
+void AssetLoader::EnqueueUploads(std::vector<std::function<void()>> uploads) {
+    std::lock_guard<std::mutex> lock(m_UploadMutex);
+    for (auto& upload : uploads) {
+        m_Uploads.push_back(std::move(upload));
+    }
+}
+
+size_t AssetLoader::ProcessUploads(double budgetMs) {
+    Timer timer;
+    size_t processed = 0;
+    do {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(m_UploadMutex);
+            if (m_Uploads.empty()) {
+                break;
+            }
+            upload = std::move(m_Uploads.front());
+            m_Uploads.pop_front();
+        }
+        upload();
+        processed++;
+    } while (timer.ElapsedMs() < budgetMs);
+    return processed;
+}
+
+size_t AssetLoader::GetPendingUploads() const {
+    std::lock_guard<std::mutex> lock(m_UploadMutex);
+    return m_Uploads.size();
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Geometry.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+/**
+ * Loads assets without stalling the render loop.
+ * Files are parsed and decoded on pool threads; everything touching GL is queued as upload steps that the GL thread
+ * runs from ProcessUploads under a per-frame time budget. Large meshes are split into slices so no single step blows it.
+ */
+class AssetLoader {
+public:
+    static constexpr double kDefaultUploadBudgetMs = 2.0;
+    static constexpr size_t kUploadSliceBytes = 1 << 20;
+
+    explicit AssetLoader(ThreadPool& pool = ThreadPool::GetGlobal())
+        : m_Pool(pool) {
+    }
+    // Waits for parses still running on the pool, pending uploads are dropped.
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    /** Parse file on a worker. A file that cannot be opened makes the future throw std::runtime_error. */
+    template <class Vertex>
+    std::future<Geometry<Vertex>> LoadGeometryAsync(const std::string& file, EObjVertexMode mode = EObjVertexMode::SHARED_POSITIONS);
+
+    std::future<ImageData> LoadImageAsync(const std::string& file);
+
+    /**
+     * Parse file on a worker, run process on the result there, then upload it into mesh from ProcessUploads.
+     * The future is ready once the mesh draws its new geometry; it throws std::runtime_error, and mesh is left as it
+     * was, if file cannot be opened.
+     */
+    template <class Vertex>
+    std::shared_future<void> LoadMeshAsync(const std::string& file, MeshPtr<Vertex> mesh,
+        std::function<void(Geometry<Vertex>&)> process = {}, EObjVertexMode mode = EObjVertexMode::SHARED_POSITIONS);
+
+    std::shared_future<TexturePtr> LoadTextureAsync(const std::string& file);
+
+    /** Queue steps to run on the GL thread, in order. */
+    void EnqueueUploads(std::vector<std::function<void()>> uploads);
+
+    /**
+     * Run queued upload steps until the queue is empty or budgetMs has passed; at least one step runs.
+     * Call once per frame on the GL thread. Returns the number of steps run.
+     */
+    size_t ProcessUploads(double budgetMs = kDefaultUploadBudgetMs);
+
+    size_t GetPendingUploads() const;
+
+private:
+    /** Run task on the pool, counted so the destructor can wait for it. */
+    template <class Task>
+    void RunOnPool(Task&& task);
+
+    /** Geometry::LoadObj, throwing instead of returning an empty geometry when file cannot be opened. */
+    template <class Vertex>
+    static Geometry<Vertex> LoadObjOrThrow(const std::string& file, EObjVertexMode mode);
+
+    template <class Vertex>
+    void EnqueueMeshUpload(std::shared_ptr<Geometry<Vertex>> geometry, MeshPtr<Vertex> mesh, std::shared_ptr<std::promise<void>> uploaded);
+
+    ThreadPool& m_Pool;
+
+    mutable std::mutex m_UploadMutex;
+    std::deque<std::function<void()>> m_Uploads;
+
+    std::mutex m_InFlightMutex;
+    std::condition_variable m_InFlightDone;
+    size_t m_InFlight = 0;
+};
+
+template <class Task>
+void AssetLoader::RunOnPool(Task&& task) {
+    {
+        std::lock_guard<std::mutex> lock(m_InFlightMutex);
+        m_InFlight++;
+    }
+    m_Pool.Submit([this, task = std::forward<Task>(task)]() mutable {
+        task();
+        std::lock_guard<std::mutex> lock(m_InFlightMutex);
+        if (--m_InFlight == 0) {
+            m_InFlightDone.notify_all();
+        }
+    });
+}
+
+template <class Vertex>
+Geometry<Vertex> AssetLoader::LoadObjOrThrow(const std::string& file, EObjVertexMode mode) {
+    if (!std::ifstream(file, std::ifstream::binary).is_open()) {
+        throw std::runtime_error("cannot open " + file);
+    }
+    return Geometry<Vertex>::LoadObj(file, mode);
+}
+
+template <class Vertex>
+std::future<Geometry<Vertex>> AssetLoader::LoadGeometryAsync(const std::string& file, EObjVertexMode mode) {
+    auto loaded = std::make_shared<std::promise<Geometry<Vertex>>>();
+    std::future<Geometry<Vertex>> result = loaded->get_future();
+    RunOnPool([file, mode, loaded]() {
+        try {
+            loaded->set_value(LoadObjOrThrow<Vertex>(file, mode));
+        } catch (...) {
+            loaded->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+template <class Vertex>
+std::shared_future<void> AssetLoader::LoadMeshAsync(
+    const std::string& file, MeshPtr<Vertex> mesh, std::function<void(Geometry<Vertex>&)> process, EObjVertexMode mode) {
+    auto uploaded = std::make_shared<std::promise<void>>();
+    std::shared_future<void> result = uploaded->get_future().share();
+    RunOnPool([this, file, mesh, process = std::move(process), mode, uploaded]() {
+        try {
+            auto geometry = std::make_shared<Geometry<Vertex>>(LoadObjOrThrow<Vertex>(file, mode));
+            if (process) {
+                process(*geometry);
+            }
+            EnqueueMeshUpload(std::move(geometry), mesh, uploaded);
+        } catch (...) {
+            uploaded->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+template <class Vertex>
+void AssetLoader::EnqueueMeshUpload(
+    std::shared_ptr<Geometry<Vertex>> geometry, MeshPtr<Vertex> mesh, std::shared_ptr<std::promise<void>> uploaded) {
+    std::vector<std::function<void()>> steps;
+    const size_t vertexCount = geometry->GetNumVertices();
+    const size_t indexCount = geometry->GetNumIndices();
+    steps.push_back([mesh, vertexCount, indexCount]() { mesh->BeginUpload(vertexCount, indexCount); });
+
+    const size_t sliceVertices = std::max<size_t>(1, kUploadSliceBytes / sizeof(Vertex));
+    for (size_t first = 0; first < vertexCount; first += sliceVertices) {
+        const size_t count = std::min(sliceVertices, vertexCount - first);
+        steps.push_back([mesh, geometry, first, count]() { mesh->UploadVertices(first, geometry->GetVertices().data() + first, count); });
+    }
+    const size_t sliceIndices = kUploadSliceBytes / sizeof(unsigned int);
+    for (size_t first = 0; first < indexCount; first += sliceIndices) {
+        const size_t count = std::min(sliceIndices, indexCount - first);
+        steps.push_back([mesh, geometry, first, count]() { mesh->UploadIndices(first, geometry->GetIndices().data() + first, count); });
+    }
+
+    steps.push_back([mesh, geometry, uploaded]() {
+        mesh->EndUpload(std::move(*geometry));
+        uploaded->set_value();
+    });
+    EnqueueUploads(std::move(steps));
+}
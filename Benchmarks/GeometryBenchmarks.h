@@ -0,0 +1,751 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Geometry.h"
+#include "GeometrySoA.h"
+#include "MappedFile.h"
+#include "Profile.h"
+#include "ThreadPool.h"
+#include "VertexPacked.h"
+
+/**
+ * Offline CPU benchmarks for Geometry. They need no GL context and print their results to stdout.
+ */
+namespace GeometryBenchmarks {
+
+inline double ToMBPerSecond(size_t bytes, double ms) {
+    return ms > 0.0 ? (bytes / 1.0e6) / (ms / 1000.0) : 0.0;
+}
+
+inline size_t GetFileSize(const std::string& file) {
+    MappedFile mappedFile(file);
+    return mappedFile.Size();
+}
+
+/** Open a generated file for writing, creating its directory. Prints the reason and returns false if that fails. */
+inline bool OpenGeneratedFile(const std::string& file, std::ofstream& out) {
+    const std::filesystem::path directory = std::filesystem::path(file).parent_path();
+    std::error_code error;
+    if (!directory.empty()) {
+        std::filesystem::create_directories(directory, error);
+    }
+    out.open(file, std::ofstream::binary | std::ofstream::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write " << file << (error ? ": " + error.message() : std::string()) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** Flush and close a generated file. If any write failed (e.g. the disk is full), deletes it, prints why and returns false. */
+inline bool CloseGeneratedFile(const std::string& file, std::ofstream& out) {
+    out.close();
+    if (!out) {
+        std::cerr << "Writing " << file << " failed, deleted it" << std::endl;
+        std::remove(file.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write a flat grid of "v"/"vn" records with "f v//vn" quads, roughly targetBytes in size.
+ * Returns false, leaving no file behind, if the file cannot be written.
+ */
+inline bool WriteSyntheticObj(const std::string& file, size_t targetBytes) {
+    // One grid vertex costs ~90 bytes of text: its "v", its "vn" and one quad line.
+    constexpr size_t bytesPerGridVertex = 90;
+    const auto side = static_cast<unsigned int>(std::sqrt(static_cast<double>(targetBytes / bytesPerGridVertex))) + 2;
+
+    std::ofstream out;
+    if (!OpenGeneratedFile(file, out)) {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+    // LoadObjStream consumes the first line as a header.
+    out << "# synthetic grid " << side << "x" << side << "\n";
+    char line[128];
+    for (unsigned int y = 0; y < side; y++) {
+        for (unsigned int x = 0; x < side; x++) {
+            const float height = 0.05f * std::sin(0.1f * x) * std::cos(0.1f * y);
+            int length = std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvn 0.000000 1.000000 0.000000\n", x * 0.01f, height,
+                y * 0.01f);
+            out.write(line, length);
+        }
+    }
+    for (unsigned int y = 0; y + 1 < side; y++) {
+        for (unsigned int x = 0; x + 1 < side; x++) {
+            const unsigned int a = y * side + x + 1, b = a + 1, c = a + side + 1, d = a + side;
+            int length = std::snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u %u//%u\n", a, a, b, b, c, c, d, d);
+            out.write(line, length);
+        }
+    }
+    return CloseGeneratedFile(file, out);
+}
+
+/**
+ * Write roughly targetBytes of separate cornersPerFace-gons, each with its own "v" records.
+ * Concave faces are stars (alternating radii, cornersPerFace must be even), so they take the ear-clipping path.
+ */
+inline bool WritePolygonObj(const std::string& file, size_t targetBytes, unsigned int cornersPerFace, bool bConcave) {
+    std::ofstream out;
+    if (!OpenGeneratedFile(file, out)) {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+    out << "# synthetic " << cornersPerFace << "-gons\n";
+    char line[128];
+    size_t written = 0;
+    for (unsigned int face = 0; written < targetBytes; face++) {
+        const float centerX = static_cast<float>(face % 1024), centerZ = static_cast<float>(face / 1024);
+        for (unsigned int i = 0; i < cornersPerFace; i++) {
+            const float angle = 6.2831853f * i / cornersPerFace;
+            const float radius = bConcave && i % 2 ? 0.2f : 0.45f;
+            int length = std::snprintf(
+                line, sizeof(line), "v %.6f 0.000000 %.6f\n", centerX + radius * std::cos(angle), centerZ - radius * std::sin(angle));
+            out.write(line, length);
+            written += length;
+        }
+        out.put('f');
+        for (unsigned int i = 0; i < cornersPerFace; i++) {
+            int length = std::snprintf(line, sizeof(line), " -%u", cornersPerFace - i);
+            out.write(line, length);
+            written += length;
+        }
+        out.put('\n');
+        written += 2;
+    }
+    return CloseGeneratedFile(file, out);
+}
+
+template <class Vertex>
+bool SameGeometry(const Geometry<Vertex>& a, const Geometry<Vertex>& b) {
+    if (a.GetIndices() != b.GetIndices() || a.GetNumVertices() != b.GetNumVertices()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.GetNumVertices(); i++) {
+        const Vertex& vertexA = a.GetVertices()[i];
+        const Vertex& vertexB = b.GetVertices()[i];
+        if (vertexA.position != vertexB.position || vertexA.normal != vertexB.normal) {
+            return false;
+        }
+        if constexpr (requires { vertexA.texUV; }) {
+            if (vertexA.texUV != vertexB.texUV) {
+                return false;
+            }
+        }
+        if constexpr (requires { vertexA.color; }) {
+            if (vertexA.color != vertexB.color) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Compare LoadObj against the reference LoadObjStream on the same file. Returns false if their geometry differs in any
+ * index or vertex attribute; a missing file is skipped and passes.
+ */
+template <class Vertex>
+bool BenchmarkObjLoading(const std::string& file) {
+    const size_t bytes = GetFileSize(file);
+    if (bytes == 0) {
+        std::cout << "[ObjLoading] " << file << " not found, skipped" << std::endl;
+        return true;
+    }
+
+    Timer timer;
+    Geometry<Vertex> reference = Geometry<Vertex>::LoadObjStream(file);
+    const double streamMs = timer.ElapsedMs();
+
+    timer.Reset();
+    Geometry<Vertex> mapped = Geometry<Vertex>::LoadObj(file, EObjVertexMode::SHARED_POSITIONS, false);
+    const double mappedMs = timer.ElapsedMs();
+
+    const bool bMatch = SameGeometry(reference, mapped);
+    float maxError = 0.0f;
+    if (reference.GetNumVertices() == mapped.GetNumVertices()) {
+        for (size_t i = 0; i < mapped.GetNumVertices(); i++) {
+            maxError = std::max(maxError, glm::length(reference.GetVertices()[i].position - mapped.GetVertices()[i].position));
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << "[ObjLoading] " << file << " " << bytes / 1.0e6 << " MB\n"
+              << "  LoadObjStream: " << streamMs << " ms, " << ToMBPerSecond(bytes, streamMs) << " MB/s\n"
+              << "  LoadObj:       " << mappedMs << " ms, " << ToMBPerSecond(bytes, mappedMs) << " MB/s\n"
+              << "  speedup x" << streamMs / mappedMs << ", results " << (bMatch ? "match" : "DIFFER")
+              << std::scientific << ", max position error " << maxError << std::defaultfloat << std::endl;
+    return bMatch;
+}
+
+/**
+ * Sweep ParseObjParallel over 1, 2, 4, ... threads up to the hardware concurrency.
+ * The file is mapped once and parsed serially first, so every run reads warm pages.
+ */
+template <class Vertex>
+void BenchmarkParallelObjLoading(const std::string& file) {
+    MappedFile mappedFile(file);
+    if (mappedFile.Size() == 0) {
+        std::cout << "[ParallelObjLoading] " << file << " not found, skipped" << std::endl;
+        return;
+    }
+    Timer timer;
+    const Geometry<Vertex> serial = Geometry<Vertex>::ParseObj(mappedFile.begin(), mappedFile.end());
+    const double serialMs = timer.ElapsedMs();
+    std::cout << std::fixed << std::setprecision(1) << "[ParallelObjLoading] " << file << " " << mappedFile.Size() / 1.0e6 << " MB\n"
+              << "  ParseObj:              " << serialMs << " ms, " << ToMBPerSecond(mappedFile.Size(), serialMs) << " MB/s\n";
+
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        timer.Reset();
+        const Geometry<Vertex> parallel = Geometry<Vertex>::ParseObjParallel(mappedFile.begin(), mappedFile.end(), pool);
+        const double parallelMs = timer.ElapsedMs();
+        std::cout << "  ParseObjParallel x" << std::setw(3) << threads << ": " << parallelMs << " ms, "
+                  << ToMBPerSecond(mappedFile.Size(), parallelMs) << " MB/s, speedup x" << serialMs / parallelMs << ", results "
+                  << (SameGeometry(serial, parallel) ? "match" : "DIFFER") << "\n";
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    std::cout << std::defaultfloat << std::flush;
+}
+
+/**
+ * Compare parsing the text OBJ with loading its ".a1bin" cache: a cold load that parses and writes the cache, then a warm one.
+ */
+template <class Vertex>
+void BenchmarkObjCache(const std::string& file) {
+    const size_t bytes = GetFileSize(file);
+    if (bytes == 0) {
+        std::cout << "[ObjCache] " << file << " not found, skipped" << std::endl;
+        return;
+    }
+    const std::string cacheFile = GeometryCacheUtils::GetCachePath(file, VertexBufferLayout::FromVertex<Vertex>(), 0);
+    std::remove(cacheFile.c_str());
+
+    Timer timer;
+    const Geometry<Vertex> text = Geometry<Vertex>::LoadObj(file, EObjVertexMode::SHARED_POSITIONS, false);
+    const double textMs = timer.ElapsedMs();
+
+    timer.Reset();
+    Geometry<Vertex>::LoadObj(file, EObjVertexMode::SHARED_POSITIONS, true);
+    const double coldMs = timer.ElapsedMs();
+    const size_t cacheBytes = GetFileSize(cacheFile);
+
+    timer.Reset();
+    const Geometry<Vertex> cached = Geometry<Vertex>::LoadObj(file, EObjVertexMode::SHARED_POSITIONS, true);
+    const double warmMs = timer.ElapsedMs();
+
+    std::cout << std::fixed << std::setprecision(1) << "[ObjCache] " << file << " " << bytes / 1.0e6 << " MB, cache " << cacheBytes / 1.0e6
+              << " MB\n"
+              << "  text OBJ:            " << textMs << " ms\n"
+              << "  parse + write cache: " << coldMs << " ms\n"
+              << "  load cache:          " << warmMs << " ms, speedup x" << textMs / warmMs << ", results "
+              << (SameGeometry(text, cached) ? "match" : "DIFFER") << std::defaultfloat << std::endl;
+    std::remove(cacheFile.c_str());
+}
+
+/**
+ * Compare the two EObjVertexMode on one file: vertex/index counts, GPU bytes and parse time,
+ * plus CornerIndexMap lookups per second over the file's triangle corners.
+ */
+template <class Vertex>
+void BenchmarkObjVertexModes(const std::string& file) {
+    MappedFile mappedFile(file);
+    if (mappedFile.Size() == 0) {
+        std::cout << "[ObjVertexModes] " << file << " not found, skipped" << std::endl;
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "[ObjVertexModes] " << file << " " << mappedFile.Size() / 1.0e6 << " MB\n";
+    for (EObjVertexMode mode : {EObjVertexMode::SHARED_POSITIONS, EObjVertexMode::UNIQUE_CORNERS}) {
+        Timer timer;
+        const Geometry<Vertex> geometry = Geometry<Vertex>::ParseObj(mappedFile.begin(), mappedFile.end(), mode);
+        const double ms = timer.ElapsedMs();
+        const size_t gpuBytes = geometry.GetNumVertices() * sizeof(Vertex) + geometry.GetNumIndices() * sizeof(unsigned int);
+        std::cout << (mode == EObjVertexMode::SHARED_POSITIONS ? "  SHARED_POSITIONS: " : "  UNIQUE_CORNERS:  ") << ms << " ms, "
+                  << geometry.GetNumVertices() << " verts, " << geometry.GetNumIndices() << " inds, corners per vertex "
+                  << static_cast<double>(geometry.GetNumIndices()) / std::max<size_t>(1, geometry.GetNumVertices()) << ", "
+                  << gpuBytes / 1.0e6 << " MB on GPU\n";
+    }
+
+    using namespace GeometryOBJUtils;
+    // Records seen so far: relative indices count back from the face's line, as in ParseObjChunk.
+    ObjRecordCounts cursor;
+    std::vector<ObjCorner> face;
+    ObjFaceList faces;
+    for (const char* p = mappedFile.begin(); p < mappedFile.end(); p = SkipLine(p, mappedFile.end())) {
+        switch (ClassifyRecord(p, mappedFile.end())) {
+            case EObjRecord::POSITION: cursor.positions++; break;
+            case EObjRecord::NORMAL: cursor.normals++; break;
+            case EObjRecord::UV: cursor.uvs++; break;
+            case EObjRecord::FACE: {
+                p = ParseFaceCorners(p, mappedFile.end(), cursor, face);
+                faces.AddFace(face);
+                break;
+            }
+            case EObjRecord::OTHER: break;
+        }
+    }
+    Timer timer;
+    CornerIndexMap cornerIndices(cursor.positions);
+    unsigned int nextIndex = 0;
+    for (const auto& corner : faces.triangles) {
+        bool bInserted = false;
+        cornerIndices.FindOrInsert(corner, nextIndex, bInserted);
+        nextIndex += bInserted;
+    }
+    const double mapMs = timer.ElapsedMs();
+    std::cout << "  CornerIndexMap: " << faces.triangles.size() << " lookups in " << mapMs << " ms, "
+              << (mapMs > 0.0 ? faces.triangles.size() / (mapMs * 1000.0) : 0.0) << " M lookups/s" << std::defaultfloat << std::endl;
+}
+
+/**
+ * Triangles per second of ParseObj on quads (the legacy path) against convex and concave n-gons of the same byte size.
+ */
+template <class Vertex>
+void BenchmarkObjPolygons(size_t targetBytes = size_t(256) << 20) {
+    struct Case {
+        const char* name;
+        unsigned int cornersPerFace;
+        bool bConcave;
+    };
+    const Case cases[] = {{"quads", 4, false}, {"convex 8-gons", 8, false}, {"concave 8-stars", 8, true}, {"concave 16-stars", 16, true}};
+    const std::string file = "res/models/synthetic_polygons.obj";
+    std::cout << std::fixed << std::setprecision(1) << "[ObjPolygons] " << targetBytes / 1.0e6 << " MB per file\n";
+    for (const Case& test : cases) {
+        if (!WritePolygonObj(file, targetBytes, test.cornersPerFace, test.bConcave)) {
+            std::cout << "  " << std::setw(16) << test.name << ": skipped\n";
+            continue;
+        }
+        MappedFile mappedFile(file);
+        Timer timer;
+        const Geometry<Vertex> geometry = Geometry<Vertex>::ParseObj(mappedFile.begin(), mappedFile.end());
+        const double ms = timer.ElapsedMs();
+        const size_t triangles = geometry.GetNumIndices() / 3;
+        std::cout << "  " << std::setw(16) << test.name << ": " << ms << " ms, " << triangles << " triangles, "
+                  << (ms > 0.0 ? triangles / (ms * 1000.0) : 0.0) << " M triangles/s, " << ToMBPerSecond(mappedFile.Size(), ms)
+                  << " MB/s\n";
+    }
+    std::cout << std::defaultfloat << std::flush;
+    std::remove(file.c_str());
+}
+
+/** Largest component difference and angle in degrees between the normals of a and b, over vertices where a is finite. */
+template <class Vertex>
+std::pair<float, float> CompareNormals(const Geometry<Vertex>& a, const Geometry<Vertex>& b) {
+    float maxDifference = 0.0f;
+    float maxAngle = 0.0f;
+    for (size_t i = 0; i < a.GetNumVertices(); i++) {
+        const glm::vec3& normalA = a.GetVertices()[i].normal;
+        const glm::vec3& normalB = b.GetVertices()[i].normal;
+        if (!std::isfinite(normalA.x) || !std::isfinite(normalA.y) || !std::isfinite(normalA.z)) {
+            continue;
+        }
+        const glm::vec3 difference = glm::abs(normalA - normalB);
+        maxDifference = std::max({maxDifference, difference.x, difference.y, difference.z});
+        maxAngle = std::max(maxAngle, glm::degrees(std::atan2(glm::length(glm::cross(normalA, normalB)), glm::dot(normalA, normalB))));
+    }
+    return {maxDifference, maxAngle};
+}
+
+/**
+ * Time GenerateNormals against GenerateNormalsSerial on a sphere of sectorCount x stackCount quads.
+ * Area-weighted and flat results must match the serial ones within tolerance; angle weighting is only timed and
+ * its deviation reported, on a uniform sphere it stays within a fraction of a degree.
+ */
+template <class Vertex>
+bool BenchmarkGenerateNormals(unsigned int sectorCount = 1600, unsigned int stackCount = 1600, float tolerance = 1.0e-6f) {
+    Geometry<Vertex> reference = Geometry<Vertex>::GenerateSphere(1.0f, sectorCount, stackCount);
+    std::cout << std::fixed << std::setprecision(1) << "[GenerateNormals] " << reference.GetNumVertices() << " verts, "
+              << reference.GetNumIndices() / 3 << " triangles, " << ThreadPool::GetGlobal().GetThreadCount() << " threads\n";
+    bool bMatch = true;
+    auto report = [&](const char* name, double ms, double referenceMs, const Geometry<Vertex>& result, const Geometry<Vertex>& expected,
+                      bool bChecked) {
+        const auto [maxDifference, maxAngle] = CompareNormals(expected, result);
+        const bool bWithinTolerance = maxDifference <= tolerance;
+        bMatch = bMatch && (!bChecked || bWithinTolerance);
+        std::cout << "  " << std::setw(16) << name << ": " << ms << " ms, x" << std::setprecision(2) << (ms > 0.0 ? referenceMs / ms : 0.0)
+                  << std::scientific << ", max diff " << maxDifference << std::fixed << ", max angle " << maxAngle << " deg"
+                  << (bChecked ? (bWithinTolerance ? ", ok" : ", DIFFER") : "") << std::setprecision(1) << "\n";
+    };
+
+    const Geometry<Vertex> positions = reference;
+    Timer timer;
+    reference.GenerateNormalsSerial(false);
+    const double serialMs = timer.ElapsedMs();
+    std::cout << "  " << std::setw(16) << "serial smooth" << ": " << serialMs << " ms\n";
+
+    Geometry<Vertex> area = positions;
+    timer.Reset();
+    area.GenerateNormals(false, ENormalWeighting::AREA);
+    report("parallel area", timer.ElapsedMs(), serialMs, area, reference, true);
+
+    Geometry<Vertex> angle = positions;
+    timer.Reset();
+    angle.GenerateNormals(false, ENormalWeighting::ANGLE);
+    report("parallel angle", timer.ElapsedMs(), serialMs, angle, reference, false);
+
+    Geometry<Vertex> flatReference = positions;
+    timer.Reset();
+    flatReference.GenerateNormalsSerial(true);
+    const double serialFlatMs = timer.ElapsedMs();
+    std::cout << "  " << std::setw(16) << "serial flat" << ": " << serialFlatMs << " ms\n";
+
+    Geometry<Vertex> flat = positions;
+    timer.Reset();
+    flat.GenerateNormals(true);
+    report("parallel flat", timer.ElapsedMs(), serialFlatMs, flat, flatReference, true);
+
+    std::cout << std::defaultfloat << std::flush;
+    return bMatch;
+}
+
+/**
+ * Split vertices with GenerateCreaseNormals on a few shapes with known hard edges and report the vertex count growth,
+ * next to the 3 vertices per triangle that un-indexing for flat shading would need.
+ * The largest angle between a corner's normal and its face shows how far smoothing bends normals within a group.
+ */
+template <class Vertex>
+void BenchmarkCreaseNormals(float creaseAngleDegrees = 30.0f) {
+    struct Case {
+        const char* name;
+        Geometry<Vertex> geometry;
+    };
+    Case cases[] = {{"cube", Geometry<Vertex>(EBasicGeometry::CUBE)}, {"hexagonal prism", Geometry<Vertex>::GeneratePrism(6)},
+        {"cylinder", Geometry<Vertex>::GeneratePrism(64)}, {"sphere", Geometry<Vertex>::GenerateSphere(1.0f, 1000, 1000)}};
+    std::cout << std::fixed << std::setprecision(1) << "[CreaseNormals] " << creaseAngleDegrees << " deg\n";
+    for (Case& test : cases) {
+        Geometry<Vertex>& geometry = test.geometry;
+        const size_t vertexCount = geometry.GetNumVertices();
+        Timer timer;
+        const size_t added = geometry.GenerateCreaseNormals(creaseAngleDegrees);
+        const double ms = timer.ElapsedMs();
+
+        float maxAngle = 0.0f;
+        const auto& vertices = geometry.GetVertices();
+        const auto& indices = geometry.GetIndices();
+        for (size_t corner = 0; corner < indices.size(); corner++) {
+            const size_t face = corner - corner % 3;
+            const glm::vec3& positionA = vertices[indices[face]].position;
+            const glm::vec3 faceNormal =
+                glm::cross(vertices[indices[face + 1]].position - positionA, vertices[indices[face + 2]].position - positionA);
+            const glm::vec3& normal = vertices[indices[corner]].normal;
+            const float angle = std::atan2(glm::length(glm::cross(faceNormal, normal)), glm::dot(faceNormal, normal));
+            maxAngle = std::max(maxAngle, glm::degrees(angle));
+        }
+        std::cout << "  " << std::setw(16) << test.name << ": " << vertexCount << " -> " << geometry.GetNumVertices() << " verts (+"
+                  << (vertexCount > 0 ? 100.0 * added / vertexCount : 0.0) << "%), un-indexed " << indices.size() << ", " << ms
+                  << " ms, max corner deviation " << maxAngle << " deg\n";
+    }
+    std::cout << std::defaultfloat << std::flush;
+}
+
+/** Triangles of geometry as position triples rotated to start at their smallest corner (keeping winding), sorted. */
+template <class Vertex>
+std::vector<std::array<glm::vec3, 3>> CanonicalTriangles(const Geometry<Vertex>& geometry) {
+    auto less = [](const glm::vec3& a, const glm::vec3& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+    std::vector<std::array<glm::vec3, 3>> triangles;
+    const auto& indices = geometry.GetIndices();
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<glm::vec3, 3> triangle = {geometry.GetVertices()[indices[i]].position, geometry.GetVertices()[indices[i + 1]].position,
+            geometry.GetVertices()[indices[i + 2]].position};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end(), less), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end(), [&](const auto& a, const auto& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+    });
+    return triangles;
+}
+
+/**
+ * Simulate a FIFO cache of cacheSize entries before and after OptimizeVertexCache, on generated meshes as emitted and
+ * on a sphere whose triangles and vertices were shuffled, the worst case for an unoptimized OBJ.
+ * Checks that the reordered meshes still hold the same triangles with the same winding.
+ */
+template <class Vertex>
+bool BenchmarkVertexCache(unsigned int cacheSize = GeometryVertexCacheUtils::kDefaultCacheSize) {
+    using namespace GeometryVertexCacheUtils;
+    Geometry<Vertex> shuffled = Geometry<Vertex>::GenerateSphere(1.0f, 500, 500);
+    {
+        std::mt19937 random(42);
+        std::vector<unsigned int> remap(shuffled.GetNumVertices());
+        std::iota(remap.begin(), remap.end(), 0);
+        std::shuffle(remap.begin(), remap.end(), random);
+        std::vector<Vertex> vertices(remap.size());
+        for (size_t vertex = 0; vertex < remap.size(); vertex++) {
+            vertices[remap[vertex]] = shuffled.GetVertices()[vertex];
+        }
+        std::vector<std::array<unsigned int, 3>> triangles;
+        const auto& indices = shuffled.GetIndices();
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            triangles.push_back({remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]});
+        }
+        std::shuffle(triangles.begin(), triangles.end(), random);
+        std::vector<unsigned int> shuffledIndices;
+        for (const auto& triangle : triangles) {
+            shuffledIndices.insert(shuffledIndices.end(), triangle.begin(), triangle.end());
+        }
+        shuffled = Geometry<Vertex>(vertices, shuffledIndices);
+    }
+    struct Case {
+        const char* name;
+        Geometry<Vertex> geometry;
+    };
+    Case cases[] = {{"cylinder", Geometry<Vertex>::GeneratePrism(256)}, {"sphere", Geometry<Vertex>::GenerateSphere(1.0f, 500, 500)},
+        {"shuffled sphere", shuffled}};
+
+    bool bPreserved = true;
+    std::cout << std::fixed << std::setprecision(3) << "[VertexCache] FIFO " << cacheSize << " entries, ACMR / ATVR\n";
+    for (const Case& test : cases) {
+        const VertexCacheStats before = SimulateVertexCache(test.geometry.GetIndices(), test.geometry.GetNumVertices(), cacheSize);
+        const auto triangles = CanonicalTriangles(test.geometry);
+        std::cout << "  " << std::setw(16) << test.name << ": " << test.geometry.GetNumIndices() / 3 << " triangles, as emitted "
+                  << before.acmr << " / " << before.atvr;
+        for (const bool bReduceOverdraw : {false, true}) {
+            Geometry<Vertex> optimized = test.geometry;
+            Timer timer;
+            optimized.OptimizeVertexCache(cacheSize, bReduceOverdraw);
+            const double ms = timer.ElapsedMs();
+            const VertexCacheStats after = SimulateVertexCache(optimized.GetIndices(), optimized.GetNumVertices(), cacheSize);
+            const bool bSame = CanonicalTriangles(optimized) == triangles;
+            bPreserved = bPreserved && bSame;
+            std::cout << (bReduceOverdraw ? ", +overdraw " : ", tipsify ") << after.acmr << " / " << after.atvr << " in "
+                      << std::setprecision(1) << ms << " ms" << std::setprecision(3) << (bSame ? "" : " (TRIANGLES DIFFER)");
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::defaultfloat << std::flush;
+    return bPreserved;
+}
+
+/**
+ * Build an LOD chain level by level as GenerateLods does and report triangle counts, quadric error and decimation
+ * throughput per level. Checks that every seam and border vertex of the full geometry survives in the last level.
+ */
+template <class Vertex>
+bool BenchmarkSimplify(
+    const Geometry<Vertex>& geometry, const std::string& name, const std::vector<float>& triangleRatios = {0.5f, 0.25f, 0.1f, 0.02f}) {
+    const size_t triangleCount = geometry.GetNumIndices() / 3;
+    const std::vector<bool> bLocked = GeometrySimplifyUtils::FindLockedVertices(geometry.GetVertices(), geometry.GetIndices());
+    std::cout << std::fixed << std::setprecision(1) << "[Simplify] " << name << ": " << geometry.GetNumVertices() << " verts, "
+              << triangleCount << " triangles, " << std::count(bLocked.begin(), bLocked.end(), true) << " seam/border verts\n";
+
+    Geometry<Vertex> level = geometry;
+    Timer chainTimer;
+    for (const float ratio : triangleRatios) {
+        const size_t sourceTriangles = level.GetNumIndices() / 3;
+        const auto targetTriangles = static_cast<size_t>(ratio * triangleCount);
+        double error = 0.0;
+        Timer timer;
+        level = level.Simplify(targetTriangles, DBL_MAX, &error);
+        const double ms = timer.ElapsedMs();
+        const size_t triangles = level.GetNumIndices() / 3;
+        std::cout << "  " << std::setw(5) << ratio * 100.0f << "%: " << triangles << " triangles (target " << targetTriangles
+                  << "), " << level.GetNumVertices() << " verts, error " << std::scientific << std::setprecision(2) << std::sqrt(error)
+                  << std::fixed << std::setprecision(1) << ", " << ms << " ms, "
+                  << (ms > 0.0 ? (sourceTriangles - triangles) / (ms * 1000.0) : 0.0) << " M triangles removed/s\n";
+    }
+    const double chainMs = chainTimer.ElapsedMs();
+
+    // Collapses keep the surviving vertices unchanged, so locked vertices must be found verbatim.
+    auto less = [](const glm::vec3& a, const glm::vec3& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+    std::vector<glm::vec3> kept;
+    for (const Vertex& vertex : level.GetVertices()) {
+        kept.push_back(vertex.position);
+    }
+    std::sort(kept.begin(), kept.end(), less);
+    bool bSeamsKept = true;
+    for (size_t vertex = 0; vertex < bLocked.size(); vertex++) {
+        const glm::vec3& position = geometry.GetVertices()[vertex].position;
+        bSeamsKept = bSeamsKept && (!bLocked[vertex] || std::binary_search(kept.begin(), kept.end(), position, less));
+    }
+    std::cout << "  chain " << chainMs << " ms, " << (chainMs > 0.0 ? triangleCount / (chainMs * 1000.0) : 0.0)
+              << " M input triangles/s, seams and borders " << (bSeamsKept ? "kept" : "BROKEN") << std::defaultfloat << std::endl;
+    return bSeamsKept;
+}
+
+/** Unit sphere with every attribute set: normals, UVs from longitude and latitude, colors from the normals. */
+inline Geometry<VertexColorNormalTexture> MakeAttributeSphere(unsigned int sectorCount, unsigned int stackCount) {
+    Geometry<VertexNormal> sphere = Geometry<VertexNormal>::GenerateSphere(1.0f, sectorCount, stackCount);
+    sphere.GenerateNormals(false);
+    std::vector<VertexColorNormalTexture> vertices(sphere.GetNumVertices());
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+        const glm::vec3 normal = sphere.GetVertices()[vertex].normal;
+        vertices[vertex].position = sphere.GetVertices()[vertex].position;
+        vertices[vertex].normal = normal;
+        vertices[vertex].color = glm::vec4(normal * 0.5f + glm::vec3(0.5f), 1.0f);
+        vertices[vertex].texUV = glm::vec2(std::atan2(normal.z, normal.x) / (2.0f * glm::pi<float>()) + 0.5f,
+            std::asin(std::clamp(normal.y, -1.0f, 1.0f)) / glm::pi<float>() + 0.5f);
+    }
+    return Geometry<VertexColorNormalTexture>(vertices, sphere.GetIndices());
+}
+
+/**
+ * Pack geometry into PackedVertex and report the vertex memory of both and the largest error after unpacking:
+ * positions relative to the bounding sphere radius, normals as angles, UVs and colors in absolute units.
+ */
+template <class PackedVertex>
+void BenchmarkVertexPacking(const Geometry<typename PackedVertex::Source>& geometry, const std::string& name) {
+    using Source = typename PackedVertex::Source;
+    const std::vector<Source>& vertices = geometry.GetVertices();
+    Timer timer;
+    const VertexQuantization quantization = VertexQuantization::FromVertices(vertices);
+    const std::vector<PackedVertex> packed = PackVertices<PackedVertex>(vertices, quantization);
+    const double ms = timer.ElapsedMs();
+    const std::vector<Source> unpacked = UnpackVertices(packed, quantization);
+
+    const float radius = geometry.GetBoundingSphere().radius;
+    float positionError = 0.0f, normalDegrees = 0.0f, uvError = 0.0f, colorError = 0.0f;
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+        const Source& a = vertices[vertex];
+        const Source& b = unpacked[vertex];
+        positionError = std::max(positionError, glm::length(a.position - b.position));
+        if constexpr (requires { a.normal; }) {
+            if (glm::dot(a.normal, a.normal) > 0.0f) {
+                const float cosine = glm::dot(glm::normalize(a.normal), glm::normalize(b.normal));
+                normalDegrees = std::max(normalDegrees, glm::degrees(std::acos(std::clamp(cosine, -1.0f, 1.0f))));
+            }
+        }
+        if constexpr (requires { a.texUV; }) {
+            uvError = std::max({uvError, std::abs(a.texUV.x - b.texUV.x), std::abs(a.texUV.y - b.texUV.y)});
+        }
+        if constexpr (requires { a.color; }) {
+            for (int i = 0; i < 4; i++) {
+                colorError = std::max(colorError, std::abs(a.color[i] - b.color[i]));
+            }
+        }
+    }
+    const size_t sourceBytes = vertices.size() * sizeof(Source);
+    const size_t packedBytes = packed.size() * sizeof(PackedVertex);
+    std::cout << std::fixed << std::setprecision(1) << "[VertexPacking] " << name << ": " << vertices.size() << " verts, "
+              << sizeof(Source) << " -> " << sizeof(PackedVertex) << " bytes per vertex, " << sourceBytes / 1.0e6 << " -> "
+              << packedBytes / 1.0e6 << " MB (" << std::setprecision(2) << (packedBytes > 0 ? double(sourceBytes) / packedBytes : 0.0)
+              << "x), packed in " << std::setprecision(1) << ms << " ms\n"
+              << std::scientific << std::setprecision(2) << "  max error: position " << (radius > 0.0f ? positionError / radius : 0.0f)
+              << " of radius, normal " << std::fixed << std::setprecision(3) << normalDegrees << " deg, UV " << std::scientific
+              << uvError << ", color " << colorError << std::defaultfloat << std::endl;
+}
+
+/**
+ * Time the bounding box, transform and smooth normal passes on geometry and on its GeometrySoA form, best of a few runs,
+ * and the conversions between both. The SoA results must match the AoS ones: exactly for the conversions and bounds,
+ * within float rounding for the transform and normals.
+ */
+template <class Vertex>
+bool BenchmarkGeometrySoA(const Geometry<Vertex>& geometry, const std::string& name, unsigned int runs = 5) {
+    auto bestOf = [runs](auto&& pass) {
+        double bestMs = DBL_MAX;
+        for (unsigned int run = 0; run < runs; run++) {
+            Timer timer;
+            pass();
+            bestMs = std::min(bestMs, timer.ElapsedMs());
+        }
+        return bestMs;
+    };
+    Timer timer;
+    GeometrySoA<Vertex> soa(geometry);
+    const double toSoAMs = timer.ElapsedMs();
+    timer.Reset();
+    const bool bRoundTrip = SameGeometry(soa.ToGeometry(), geometry);
+    const double toAoSMs = timer.ElapsedMs();
+
+    BoundingBox aosBox, soaBox;
+    const double aosBoxMs = bestOf([&]() { aosBox = geometry.GetBoundingBox(); });
+    const double soaBoxMs = bestOf([&]() { soaBox = soa.GetBoundingBox(); });
+    const bool bSameBox = aosBox.low == soaBox.low && aosBox.high == soaBox.high;
+
+    // Alternating a rotation and its inverse keeps the geometry in place over the runs.
+    const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 inverseRotation = glm::transpose(rotation);
+    Geometry<Vertex> aos = geometry;
+    unsigned int aosRuns = 0, soaRuns = 0;
+    const double aosTransformMs = bestOf([&]() { aos.Transform(aosRuns++ % 2 == 0 ? rotation : inverseRotation); });
+    const double soaTransformMs = bestOf([&]() { soa.Transform(soaRuns++ % 2 == 0 ? rotation : inverseRotation); });
+    float transformError = 0.0f;
+    for (size_t vertex = 0; vertex < aos.GetNumVertices(); vertex++) {
+        transformError = std::max(transformError, glm::length(aos.GetVertices()[vertex].position - soa.GetPositions()[vertex]));
+    }
+
+    const double aosNormalsMs = bestOf([&]() { aos.GenerateNormals(); });
+    const double soaNormalsMs = bestOf([&]() { soa.GenerateNormals(); });
+    const auto [normalDifference, normalDegrees] = CompareNormals(aos, soa.ToGeometry());
+
+    const bool bMatch = bRoundTrip && bSameBox && transformError < 1.0e-4f && normalDifference < 1.0e-5f;
+    auto row = [](const char* pass, double aosMs, double soaMs) {
+        std::cout << "  " << std::setw(10) << pass << ": AoS " << std::setw(7) << aosMs << " ms, SoA " << std::setw(7) << soaMs
+                  << " ms, x" << (soaMs > 0.0 ? aosMs / soaMs : 0.0) << "\n";
+    };
+    std::cout << std::fixed << std::setprecision(2) << "[GeometrySoA] " << name << ": " << geometry.GetNumVertices() << " verts of "
+              << sizeof(Vertex) << " bytes, " << geometry.GetNumIndices() / 3 << " triangles\n"
+              << "  convert: to SoA " << toSoAMs << " ms, back to AoS and compare " << toAoSMs << " ms\n";
+    row("bounds", aosBoxMs, soaBoxMs);
+    row("transform", aosTransformMs, soaTransformMs);
+    row("normals", aosNormalsMs, soaNormalsMs);
+    std::cout << "  results " << (bMatch ? "match" : "DIFFER") << std::scientific << std::setprecision(1) << " (transform "
+              << transformError << ", normals " << normalDifference << ")" << std::defaultfloat << std::endl;
+    return bMatch;
+}
+
+/** Run every geometry benchmark; false if an optimized path disagreed with its reference. */
+inline bool RunObjBenchmarks(const std::string& model = "res/models/dennis.obj") {
+    bool bPassed = BenchmarkObjLoading<VertexNormal>(model);
+    BenchmarkParallelObjLoading<VertexNormal>(model);
+    BenchmarkObjCache<VertexNormal>(model);
+    BenchmarkObjVertexModes<VertexNormalTexture>(model);
+
+    const std::string synthetic = "res/models/synthetic_1gb.obj";
+    if (WriteSyntheticObj(synthetic, size_t(1) << 30)) {
+        bPassed = BenchmarkObjLoading<VertexNormal>(synthetic) && bPassed;
+        BenchmarkParallelObjLoading<VertexNormal>(synthetic);
+        BenchmarkObjCache<VertexNormal>(synthetic);
+        BenchmarkObjVertexModes<VertexNormal>(synthetic);
+        std::remove(synthetic.c_str());
+    }
+
+    BenchmarkObjPolygons<VertexNormal>();
+    bPassed = BenchmarkGenerateNormals<VertexNormal>() && bPassed;
+    BenchmarkCreaseNormals<VertexNormal>();
+    bPassed = BenchmarkVertexCache<VertexNormal>() && bPassed;
+    if (GetFileSize(model) > 0) {
+        bPassed = BenchmarkSimplify(Geometry<VertexNormalTexture>::LoadObj(model, EObjVertexMode::UNIQUE_CORNERS), model) && bPassed;
+    }
+    bPassed = BenchmarkSimplify(Geometry<VertexNormal>::GenerateSphere(1.0f, 1000, 1000), "sphere") && bPassed;
+
+    if (GetFileSize(model) > 0) {
+        BenchmarkVertexPacking<VertexPackedNormal>(Geometry<VertexNormal>::LoadObj(model), model);
+        BenchmarkVertexPacking<VertexPackedNormalTexture>(
+            Geometry<VertexNormalTexture>::LoadObj(model, EObjVertexMode::UNIQUE_CORNERS), model);
+    }
+    BenchmarkVertexPacking<VertexPackedColorNormalTexture>(MakeAttributeSphere(1000, 1000), "sphere");
+
+    bPassed = BenchmarkGeometrySoA(Geometry<VertexNormal>::GenerateSphere(1.0f, 1000, 1000), "sphere VertexNormal") && bPassed;
+    bPassed = BenchmarkGeometrySoA(MakeAttributeSphere(1000, 1000), "sphere VertexColorNormalTexture") && bPassed;
+
+    if (!bPassed) {
+        std::cerr << "Geometry benchmarks FAILED: an optimized path differs from its reference, see above" << std::endl;
+    }
+    return bPassed;
+}
+
+} // namespace GeometryBenchmarks
@@ -0,0 +1,830 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "AssetLoader.h"
+#include "BufferArena.h"
+#include "Camera.h"
+#include "FrameTimeStats.h"
+#include "GeometryBenchmarks.h"
+#include "IndexBuffer.h"
+#include "MaterialBuffer.h"
+#include "MemoryUsage.h"
+#include "OGLRenderer.h"
+#include "ObjStreamLoader.h"
+#include "Profile.h"
+#include "ProgramBinaryCache.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "ShaderLibrary.h"
+#include "Shape.h"
+#include "TransformNode.h"
+#include "VertexBuffer.h"
+
+/**
+ * Benchmarks that upload to or draw with OpenGL. They need a current GL context and print their results to stdout.
+ */
+namespace RenderBenchmarks {
+
+template <class Vertex>
+std::vector<Vertex> ReadBackVertices(const VertexBuffer<Vertex>& vertexBuffer, size_t count) {
+    std::vector<Vertex> vertices(count);
+    vertexBuffer.Bind();
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Vertex), vertices.data());
+    return vertices;
+}
+
+inline std::vector<unsigned int> ReadBackIndices(const IndexBuffer& indexBuffer) {
+    std::vector<unsigned int> indices(indexBuffer.GetCount());
+    indexBuffer.Bind();
+    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+    return indices;
+}
+
+/**
+ * Stream file into GL buffers with ObjStreamLoader and check the resident set growth against residentBudgetBytes.
+ * Then load it the in-memory way for comparison and check that both produce the same buffers.
+ * Software drivers (llvmpipe) keep buffer storage in process memory, so the buffer sizes are not charged to the budget.
+ */
+template <class Vertex>
+bool BenchmarkObjStreaming(const std::string& file, size_t blockBytes, size_t residentBudgetBytes) {
+    const size_t bytes = GeometryBenchmarks::GetFileSize(file);
+    if (bytes == 0) {
+        std::cout << "[ObjStreaming] " << file << " not found, skipped" << std::endl;
+        return true;
+    }
+    VertexBuffer<Vertex> vertexBuffer;
+    IndexBuffer indexBuffer;
+    const size_t residentBefore = GetResidentSetBytes();
+    Timer timer;
+    ObjStreamLoader<Vertex> loader(blockBytes);
+    loader.Load(file, vertexBuffer, indexBuffer);
+    glFinish();
+    const double streamMs = timer.ElapsedMs();
+    const ObjStreamStats stats = loader.GetStats();
+    const size_t bufferBytes = stats.vertexCount * sizeof(Vertex) + stats.indexCount * sizeof(unsigned int);
+    const size_t streamResident = stats.peakResidentBytes > residentBefore + bufferBytes ? stats.peakResidentBytes - residentBefore - bufferBytes : 0;
+
+    timer.Reset();
+    const Geometry<Vertex> geometry = Geometry<Vertex>::LoadObj(file, EObjVertexMode::SHARED_POSITIONS, false);
+    const double loadMs = timer.ElapsedMs();
+    const size_t residentAfterLoad = GetResidentSetBytes();
+    const size_t loadResident = residentAfterLoad > residentBefore ? residentAfterLoad - residentBefore : 0;
+
+    const bool bMatch = ReadBackIndices(indexBuffer) == geometry.GetIndices()
+        && GeometryBenchmarks::SameGeometry(geometry, Geometry<Vertex>(ReadBackVertices(vertexBuffer, stats.vertexCount), geometry.GetIndices()));
+    const bool bWithinBudget = residentBudgetBytes == 0 || streamResident <= residentBudgetBytes;
+
+    std::cout << std::fixed << std::setprecision(1) << "[ObjStreaming] " << file << " " << bytes / 1.0e6 << " MB, block "
+              << blockBytes / 1.0e6 << " MB\n"
+              << "  stream to GL:    " << streamMs << " ms, " << GeometryBenchmarks::ToMBPerSecond(bytes, streamMs) << " MB/s, loader "
+              << stats.peakHostBytes / 1.0e6 << " MB, resident +" << streamResident / 1.0e6 << " MB besides " << bufferBytes / 1.0e6 << " MB of buffers (budget "
+              << residentBudgetBytes / 1.0e6 << " MB: " << (bWithinBudget ? "ok" : "EXCEEDED") << ")\n"
+              << "  LoadObj to host: " << loadMs << " ms, resident +" << loadResident / 1.0e6 << " MB before any Mesh copy\n"
+              << "  " << stats.vertexCount << " verts, " << stats.indexCount << " inds, results " << (bMatch ? "match" : "DIFFER")
+              << std::defaultfloat << std::endl;
+    return bWithinBudget && bMatch;
+}
+
+/**
+ * Render at least frameCount frames and load file a few frames in: once with LoadObj and a Mesh built on the GL thread,
+ * once through AssetLoader with its default upload budget. Compares the frame-time percentiles of both runs.
+ */
+template <class Vertex>
+void BenchmarkAsyncLoading(const std::string& file, unsigned int frameCount = 300) {
+    if (GeometryBenchmarks::GetFileSize(file) == 0) {
+        std::cout << "[AsyncLoading] " << file << " not found, skipped" << std::endl;
+        return;
+    }
+    constexpr unsigned int loadFrame = 10;
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    // Both runs read the binary cache, so they differ only in where the work happens.
+    Geometry<Vertex>::LoadObj(file);
+
+    // Frames are paced to 60 Hz like a vsynced swap, so a hitch shows up as frames longer than 16.7 ms.
+    constexpr double framePeriodMs = 1000.0 / 60.0;
+    auto renderFrames = [&](Scene& scene, auto&& beforeDraw, auto&& bDone) {
+        FrameTimeStats frameTimes;
+        for (unsigned int frame = 0; frame < frameCount || !bDone(); frame++) {
+            Timer timer;
+            beforeDraw(frame);
+            OGLRenderer::Clear();
+            scene.Draw(camera);
+            glFinish();
+            const double workMs = timer.ElapsedMs();
+            if (workMs < framePeriodMs) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(framePeriodMs - workMs));
+            }
+            frameTimes.AddFrame(timer.ElapsedMs());
+        }
+        return frameTimes;
+    };
+
+    Scene syncScene;
+    const FrameTimeStats syncFrames = renderFrames(
+        syncScene,
+        [&](unsigned int frame) {
+            if (frame == loadFrame) {
+                auto mesh = std::make_shared<Mesh<Vertex>>(Geometry<Vertex>::LoadObj(file), EDefaultShader::DEFAULT);
+                syncScene.AddObject(std::make_shared<Shape<Vertex>>(mesh));
+            }
+        },
+        []() { return true; });
+
+    Scene asyncScene;
+    AssetLoader assetLoader;
+    unsigned int visibleFrames = 0;
+    const FrameTimeStats asyncFrames = renderFrames(
+        asyncScene,
+        [&](unsigned int frame) {
+            if (frame == loadFrame) {
+                auto mesh = std::make_shared<Mesh<Vertex>>(Geometry<Vertex>(), EDefaultShader::DEFAULT);
+                asyncScene.AddObjectWhenReady(std::make_shared<Shape<Vertex>>(mesh), assetLoader.LoadMeshAsync<Vertex>(file, mesh));
+            }
+            assetLoader.ProcessUploads();
+            if (frame > loadFrame && asyncScene.GetPendingObjectCount() > 0) {
+                visibleFrames++;
+            }
+        },
+        [&]() { return asyncScene.GetPendingObjectCount() == 0; });
+
+    std::cout << "[AsyncLoading] " << file << "\n"
+              << "  load on GL thread: " << syncFrames.ToString() << "\n"
+              << "  AssetLoader:       " << asyncFrames.ToString() << ", visible after " << visibleFrames + 1 << " frames" << std::endl;
+}
+
+/**
+ * Create meshCount cubes twice, with buffers of their own and in one BufferArena, and draw each set frameCount times.
+ * Reports the creation time, the GL objects each set needs and the CPU time to submit a frame; all meshes share one shader
+ * so only the buffer setup differs. Then frees every other arena mesh, defragments and checks that the survivors Defragment
+ * moved still read back their geometry; returns false if one does not.
+ */
+template <class Vertex>
+bool BenchmarkBufferArena(size_t meshCount, unsigned int frameCount = 10) {
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    const ShaderPtr shader = Shader::GetDefaultShader(EDefaultShader::DEFAULT);
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+
+    auto submitMs = [&](const std::vector<std::unique_ptr<Mesh<Vertex>>>& meshes) {
+        Timer timer;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            for (const auto& mesh : meshes) {
+                if (mesh) {
+                    mesh->Draw(camera);
+                }
+            }
+        }
+        const double ms = timer.ElapsedMs() / frameCount;
+        glFinish();
+        return ms;
+    };
+
+    std::vector<std::unique_ptr<Mesh<Vertex>>> ownMeshes(meshCount);
+    Timer timer;
+    for (auto& mesh : ownMeshes) {
+        mesh = std::make_unique<Mesh<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader);
+    }
+    glFinish();
+    const double ownCreateMs = timer.ElapsedMs();
+    const double ownSubmitMs = submitMs(ownMeshes);
+
+    BufferArena<Vertex> arena;
+    std::vector<std::unique_ptr<Mesh<Vertex>>> arenaMeshes(meshCount);
+    timer.Reset();
+    for (auto& mesh : arenaMeshes) {
+        mesh = std::make_unique<Mesh<Vertex>>(cube, shader, arena);
+    }
+    glFinish();
+    const double arenaCreateMs = timer.ElapsedMs();
+    const double arenaSubmitMs = submitMs(arenaMeshes);
+
+    // The arena is fresh, so mesh i holds handle i. The even ones survive; all but the first move down.
+    std::vector<BufferArenaRange> rangesBefore;
+    for (size_t i = 0; i < arenaMeshes.size(); i += 2) {
+        rangesBefore.push_back(arena.GetRange(static_cast<typename BufferArena<Vertex>::Handle>(i)));
+    }
+    for (size_t i = 1; i < arenaMeshes.size(); i += 2) {
+        arenaMeshes[i].reset();
+    }
+    const float fragmentation = arena.GetFragmentation();
+    timer.Reset();
+    arena.Defragment();
+    glFinish();
+    const double defragmentMs = timer.ElapsedMs();
+
+    std::vector<Vertex> arenaVertices(arena.GetUsedVertices());
+    std::vector<unsigned int> arenaIndices(arena.GetUsedIndices());
+    arena.Bind();
+    arena.GetVertexBuffer().Bind();
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, arenaVertices.size() * sizeof(Vertex), arenaVertices.data());
+    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, arenaIndices.size() * sizeof(unsigned int), arenaIndices.data());
+    bool bMatch = true;
+    for (size_t survivor = 0; survivor < rangesBefore.size() && bMatch; survivor++) {
+        const BufferArenaRange& range = arena.GetRange(static_cast<typename BufferArena<Vertex>::Handle>(2 * survivor));
+        const BufferArenaRange& before = rangesBefore[survivor];
+        const bool bMoved = range.firstVertex != before.firstVertex && range.firstIndex != before.firstIndex;
+        const bool bInside =
+            range.firstVertex + range.vertexCount <= arenaVertices.size() && range.firstIndex + range.indexCount <= arenaIndices.size();
+        if ((survivor > 0 && !bMoved) || !bInside) {
+            bMatch = false;
+            break;
+        }
+        const auto firstVertex = arenaVertices.begin() + range.firstVertex;
+        const auto firstIndex = arenaIndices.begin() + range.firstIndex;
+        const std::vector<Vertex> vertices(firstVertex, firstVertex + range.vertexCount);
+        const std::vector<unsigned int> indices(firstIndex, firstIndex + range.indexCount);
+        bMatch = indices == cube.GetIndices() && GeometryBenchmarks::SameGeometry(cube, Geometry<Vertex>(vertices, indices));
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << "[BufferArena] " << meshCount << " meshes of " << cube.GetNumVertices()
+              << " verts\n"
+              << "  own buffers: create " << ownCreateMs << " ms, " << 3 * meshCount << " GL objects, submit " << ownSubmitMs
+              << " ms/frame (" << ownSubmitMs * 1.0e6 / meshCount << " ns/draw)\n"
+              << "  arena:       create " << arenaCreateMs << " ms, 3 GL objects, submit " << arenaSubmitMs << " ms/frame ("
+              << arenaSubmitMs * 1.0e6 / meshCount << " ns/draw)\n"
+              << "  freed half: fragmentation " << fragmentation << ", defragment " << defragmentMs << " ms, fragmentation after "
+              << arena.GetFragmentation() << ", moved ranges " << (bMatch ? "match" : "DIFFER") << std::defaultfloat << std::endl;
+    arenaMeshes.clear();
+    arena.Delete();
+    return bMatch;
+}
+
+/**
+ * Draw shapeCount cubes spread over meshCount solid color meshes and shaderCount programs, added to the scene in random
+ * order. Half of the meshes share a BufferArena, the others have buffers of their own. The scene is drawn directly as
+ * before the render queue, queued in insertion order and queued sorted; reports the CPU time and GL state changes per
+ * frame of each. Drawing directly sets the program, vertex array, mesh uniforms and camera for every shape.
+ */
+template <class Vertex>
+void BenchmarkRenderQueue(size_t shapeCount, size_t meshCount, size_t shaderCount, unsigned int frameCount = 10) {
+    std::mt19937 random(7);
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    std::vector<ShaderPtr> shaders;
+    // Separate programs of one source; ShaderLibrary would hand out the same one every time.
+    for (size_t i = 0; i < shaderCount; i++) {
+        shaders.push_back(std::make_shared<Shader>(Shader::GetDefaultShaderPath(EDefaultShader::SOLID_COLOR)));
+    }
+    BufferArena<Vertex> arena;
+    std::vector<MeshPtr<Vertex>> meshes;
+    for (size_t i = 0; i < meshCount; i++) {
+        const ShaderPtr& shader = shaders[random() % shaderCount];
+        MeshSolidColorPtr<Vertex> mesh = i % 2 == 0
+            ? std::make_shared<MeshSolidColor<Vertex>>(cube, shader, arena)
+            : std::make_shared<MeshSolidColor<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader);
+        mesh->SetColor(glm::vec4(float(i % 7) / 7.0f, float(i % 5) / 5.0f, float(i % 3) / 3.0f, 1.0f));
+        meshes.push_back(mesh);
+    }
+    Scene scene;
+    std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+    for (size_t i = 0; i < shapeCount; i++) {
+        const glm::vec3 location(coordinate(random), coordinate(random), coordinate(random) - 30.0f);
+        scene.AddObject(std::make_shared<Shape<Vertex>>(meshes[random() % meshCount], location));
+    }
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+
+    auto drawMs = [&]() {
+        scene.Draw(camera);
+        glFinish();
+        Timer timer;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            scene.Draw(camera);
+        }
+        const double ms = timer.ElapsedMs() / frameCount;
+        glFinish();
+        return ms;
+    };
+    scene.SetRenderQueueEnabled(false);
+    const double directMs = drawMs();
+    scene.SetRenderQueueEnabled(true);
+    scene.GetRenderQueue().SetSorting(false);
+    const double insertionMs = drawMs();
+    const RenderQueueStats insertionStats = scene.GetRenderQueue().GetStats();
+    scene.GetRenderQueue().SetSorting(true);
+    const double sortedMs = drawMs();
+    const RenderQueueStats sortedStats = scene.GetRenderQueue().GetStats();
+
+    auto statsString = [](const RenderQueueStats& stats) {
+        std::ostringstream out;
+        out << stats.GetStateChanges() << " state changes (" << stats.programBinds << " programs, " << stats.vertexArrayBinds
+            << " VAOs, " << stats.materialApplies << " materials, " << stats.cameraUpdates << " cameras)";
+        return out.str();
+    };
+    std::cout << std::fixed << std::setprecision(2) << "[RenderQueue] " << shapeCount << " shapes, " << meshCount << " meshes, "
+              << shaderCount << " programs\n"
+              << "  direct:          " << directMs << " ms/frame, " << 4 * shapeCount << " state changes\n"
+              << "  queue, unsorted: " << insertionMs << " ms/frame, " << statsString(insertionStats) << "\n"
+              << "  queue, sorted:   " << sortedMs << " ms/frame, " << statsString(sortedStats) << std::defaultfloat << std::endl;
+    arena.Delete();
+}
+
+/**
+ * Animate shapeCount cubes over meshCount shared solid color meshes, every shape moving each frame, and draw them through
+ * the render queue with and without instancing. Reports draw calls, the CPU time of Scene::Draw and the time until the
+ * GPU has finished, per frame.
+ */
+template <class Vertex>
+void BenchmarkInstancing(size_t shapeCount, size_t meshCount, unsigned int frameCount = 10) {
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    const ShaderPtr shader = Shader::GetDefaultShader(EDefaultShader::SOLID_COLOR);
+    std::vector<MeshPtr<Vertex>> meshes;
+    for (size_t i = 0; i < meshCount; i++) {
+        MeshSolidColorPtr<Vertex> mesh = std::make_shared<MeshSolidColor<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader);
+        mesh->SetColor(glm::vec4(float(i % 7) / 7.0f, float(i % 5) / 5.0f, float(i % 3) / 3.0f, 1.0f));
+        meshes.push_back(mesh);
+    }
+    Scene scene;
+    float time = 0.0f;
+    const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(shapeCount))));
+    for (size_t i = 0; i < shapeCount; i++) {
+        const glm::vec3 base(float(i % side) - 0.5f * side, float(i / side) - 0.5f * side, -float(side));
+        ShapePtr<Vertex> shape = std::make_shared<Shape<Vertex>>(meshes[i % meshCount], base);
+        shape->SetScale(glm::vec3(0.3f));
+        shape->SetUpdateMethod([shape = shape.get(), base, phase = float(i) * 0.1f, &time]() {
+            shape->SetLocation(base + glm::vec3(0.0f, 0.25f * std::sin(time + phase), 0.0f));
+        });
+        scene.AddObject(shape);
+    }
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+
+    auto run = [&](bool bInstancing) {
+        scene.GetRenderQueue().SetInstancing(bInstancing);
+        scene.Draw(camera);
+        glFinish();
+        double cpuMs = 0.0;
+        Timer frameTimer;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            time += 1.0f / 60.0f;
+            Timer timer;
+            scene.Draw(camera);
+            cpuMs += timer.ElapsedMs();
+        }
+        glFinish();
+        const double frameMs = frameTimer.ElapsedMs() / frameCount;
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << scene.GetRenderQueue().GetStats().drawCalls << " draw calls, CPU "
+            << cpuMs / frameCount << " ms, frame " << frameMs << " ms (" << 1000.0 / frameMs << " fps)";
+        return out.str();
+    };
+    const std::string separate = run(false);
+    const std::string instanced = run(true);
+    std::cout << std::fixed << std::setprecision(2) << "[Instancing] " << shapeCount << " animated cubes, " << meshCount << " meshes\n"
+              << "  one draw per shape: " << separate << "\n"
+              << "  instanced:          " << instanced << std::defaultfloat << std::endl;
+}
+
+/**
+ * Create a scene of prismCount wireframe prisms and draw its first frame, once with a program compiled per prism as
+ * Shader::GetDefaultShader used to, once with the shared programs of ShaderLibrary. Reports the time to the first finished
+ * frame and the number of GL programs the scene uses.
+ */
+template <class Vertex>
+void BenchmarkShaderLibrary(size_t prismCount) {
+    std::vector<Geometry<Vertex>> geometries;
+    for (unsigned int sides = 3; sides < 9; sides++) {
+        geometries.push_back(Geometry<Vertex>::GeneratePrism(sides));
+    }
+    const std::string shaderPath = Shader::GetDefaultShaderPath(EDefaultShader::SOLID_COLOR_WIREFRAME);
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    auto run = [&](bool bShared) {
+        ShaderLibrary::GetGlobal().Clear();
+        glFinish();
+        Timer timer;
+        Scene scene;
+        std::unordered_set<unsigned int> programs;
+        for (size_t i = 0; i < prismCount; i++) {
+            const ShaderPtr shader = bShared ? ShaderLibrary::GetGlobal().Get(shaderPath) : std::make_shared<Shader>(shaderPath);
+            const Geometry<Vertex>& geometry = geometries[i % geometries.size()];
+            auto mesh = std::make_shared<MeshSolidColorWireframe<Vertex>>(geometry.GetVertices(), geometry.GetIndices(), shader);
+            const glm::vec3 location(float(i % 40) - 20.0f, float(i / 40 % 25) - 12.0f, -30.0f);
+            scene.AddObject(std::make_shared<Shape<Vertex>>(mesh, location));
+            programs.insert(shader->m_ID);
+        }
+        // Drivers may defer part of the compile to the first draw with a program.
+        scene.Draw(camera);
+        glFinish();
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << timer.ElapsedMs() << " ms, " << programs.size() << " GL programs";
+        return out.str();
+    };
+    const std::string separate = run(false);
+    const std::string shared = run(true);
+    std::cout << "[ShaderLibrary] " << prismCount << " wireframe prisms, creation and first frame\n"
+              << "  program per mesh: " << separate << "\n"
+              << "  ShaderLibrary:    " << shared << std::endl;
+}
+
+/**
+ * Startup with and without ProgramBinaryCache: compile the default shaders and draw a cube with each, first with an empty
+ * cache (cold) and then from the binaries the first pass wrote (warm). Replaces the global cache's files.
+ * Mesa keeps its own shader cache too; for a cold first pass on Mesa, point MESA_SHADER_CACHE_DIR at an empty directory.
+ */
+template <class Vertex>
+void BenchmarkProgramBinaryCache() {
+    // LIGHTING is left out: material.shader is commented out and does not compile.
+    const std::vector<EDefaultShader> shaderTypes = {EDefaultShader::DEFAULT, EDefaultShader::COLOR, EDefaultShader::SOLID_COLOR,
+        EDefaultShader::SOLID_COLOR_WIREFRAME, EDefaultShader::VERTEX_LIGHTING};
+    ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetGlobal();
+    if (!binaryCache.IsSupported()) {
+        std::cout << "[ProgramBinaryCache] the driver offers no program binary format, every start compiles" << std::endl;
+        return;
+    }
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    auto run = [&]() {
+        binaryCache.ResetStats();
+        glFinish();
+        Timer timer;
+        Scene scene;
+        for (EDefaultShader shaderType : shaderTypes) {
+            // Bypass ShaderLibrary, which would keep the programs of the previous pass.
+            const ShaderPtr shader = std::make_shared<Shader>(Shader::GetDefaultShaderPath(shaderType));
+            scene.AddObject(std::make_shared<Shape<Vertex>>(std::make_shared<Mesh<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader)));
+        }
+        scene.Draw(camera);
+        glFinish();
+        const ProgramBinaryCache::Stats& stats = binaryCache.GetStats();
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << timer.ElapsedMs() << " ms, " << stats.loads << " loaded, " << stats.misses
+            << " compiled, " << stats.rejects << " rejected";
+        return out.str();
+    };
+    binaryCache.Clear();
+    const std::string cold = run();
+    const std::string warm = run();
+    std::cout << "[ProgramBinaryCache] " << shaderTypes.size() << " default shaders, creation and first frame\n"
+              << "  cold: " << cold << "\n"
+              << "  warm: " << warm << std::endl;
+}
+
+/** Whether filePath declares a program, i.e. has a "#shader" line that is not commented out like material.shader's. */
+inline bool HasShaderStages(const std::string& filePath) {
+    std::ifstream stream(filePath);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.rfind("#shader", 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Build every .shader file in shaderDirectory one after the other, each checked before the next compile is issued as
+ * Shader used to, then with every compile issued before the first check. With GL_KHR_parallel_shader_compile the driver
+ * compiles the second set concurrently. A define unique to each pass keeps ProgramBinaryCache and driver caches from
+ * serving either pass.
+ */
+inline void BenchmarkParallelShaderCompile(const std::string& shaderDirectory = "res/shaders") {
+    std::vector<std::string> filePaths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(shaderDirectory, error)) {
+        if (entry.path().extension() == ".shader" && HasShaderStages(entry.path().string())) {
+            filePaths.push_back(entry.path().generic_string());
+        }
+    }
+    if (filePaths.empty()) {
+        std::cout << "[ParallelShaderCompile] skipped: no shaders in " << shaderDirectory << std::endl;
+        return;
+    }
+    std::sort(filePaths.begin(), filePaths.end());
+    ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetGlobal();
+    const bool bBinaryCache = binaryCache.IsEnabled();
+    binaryCache.SetEnabled(false);
+    const auto seed = std::chrono::steady_clock::now().time_since_epoch().count();
+    unsigned int pass = 0;
+    auto run = [&](bool bDeferred) {
+        const std::vector<std::string> defines = {"BENCHMARK_PASS " + std::to_string(seed) + std::to_string(pass++)};
+        glFinish();
+        Timer timer;
+        std::vector<ShaderPtr> shaders;
+        for (const std::string& filePath : filePaths) {
+            shaders.push_back(std::make_shared<Shader>(filePath, defines));
+            if (!bDeferred) {
+                shaders.back()->Finish();
+            }
+        }
+        for (const ShaderPtr& shader : shaders) {
+            shader->Bind();
+        }
+        glFinish();
+        return timer.ElapsedMs();
+    };
+    const double serialMs = run(false);
+    const double deferredMs = run(true);
+    binaryCache.SetEnabled(bBinaryCache);
+    std::cout << std::fixed << std::setprecision(2) << "[ParallelShaderCompile] " << filePaths.size() << " shaders in " << shaderDirectory << ", "
+              << (OGLRenderer::HasExtension("GL_KHR_parallel_shader_compile") ? "with" : "without")
+              << " GL_KHR_parallel_shader_compile, " << std::thread::hardware_concurrency() << " hardware threads\n"
+              << "  compile, check, compile...: " << serialMs << " ms\n"
+              << "  all compiles, then checks:  " << deferredMs << " ms" << std::defaultfloat << std::endl;
+}
+
+/**
+ * CPU time per draw of objectCount wireframe cubes drawn one by one (render queue off), each setting its model uniform
+ * and binding its material. The cubes sit behind the camera so that the GPU does next to nothing. Then the cost of one
+ * uniform set by each path: a name in a std::string, a literal name hashed at compile time, and a UniformHandle.
+ */
+template <class Vertex>
+void BenchmarkUniformUpload(size_t objectCount, unsigned int frameCount = 20) {
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    const ShaderPtr shader = Shader::GetDefaultShader(EDefaultShader::SOLID_COLOR_WIREFRAME);
+    std::vector<MeshPtr<Vertex>> meshes;
+    for (size_t i = 0; i < 100; i++) {
+        auto mesh = std::make_shared<MeshSolidColorWireframe<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader);
+        mesh->SetColor(glm::vec4(float(i % 7) / 7.0f, float(i % 5) / 5.0f, float(i % 3) / 3.0f, 1.0f));
+        meshes.push_back(mesh);
+    }
+    Scene scene;
+    scene.SetRenderQueueEnabled(false);
+    for (size_t i = 0; i < objectCount; i++) {
+        scene.AddObject(std::make_shared<Shape<Vertex>>(meshes[i % meshes.size()], glm::vec3(float(i % 100), float(i / 100), 50.0f)));
+    }
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    scene.Draw(camera);
+    glFinish();
+    double cpuMs = 0.0;
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
+        Timer timer;
+        scene.Draw(camera);
+        cpuMs += timer.ElapsedMs();
+        glFinish();
+    }
+
+    shader->Bind();
+    const glm::mat4 model(1.0f);
+    const std::string runtimeName = "u_Model";
+    const UniformHandle handle = shader->GetUniformHandle("u_Model");
+    const size_t setCount = objectCount * 100;
+    auto setNs = [&](auto&& set) {
+        Timer timer;
+        for (size_t i = 0; i < setCount; i++) {
+            set();
+        }
+        return 1e6 * timer.ElapsedMs() / setCount;
+    };
+    const double stringNs = setNs([&]() { shader->SetUniformMat4f(runtimeName, model); });
+    const double literalNs = setNs([&]() { shader->SetUniformMat4f("u_Model", model); });
+    const double handleNs = setNs([&]() { shader->SetUniformMat4f(handle, model); });
+    glFinish();
+
+    std::cout << std::fixed << std::setprecision(2) << "[UniformUpload] " << objectCount << " objects\n"
+              << "  Scene::Draw: " << cpuMs / frameCount << " ms CPU/frame, " << 1e6 * cpuMs / frameCount / objectCount << " ns/draw\n"
+              << "  one glUniformMatrix4fv by std::string " << stringNs << " ns, by literal " << literalNs << " ns, by handle " << handleNs
+              << " ns" << std::defaultfloat << std::endl;
+}
+
+/**
+ * CPU time per frame of objectCount solid color cubes drawn one by one (render queue off) by a camera that moves every
+ * frame. Then the camera's share of it: what every draw did before the Camera uniform block (build view and projection,
+ * set them as two mat4 uniforms) against what it does now (check that the block is current), plus the one block upload
+ * per frame.
+ */
+template <class Vertex>
+void BenchmarkCameraUniforms(size_t objectCount, unsigned int frameCount = 20) {
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    const ShaderPtr shader = Shader::GetDefaultShader(EDefaultShader::SOLID_COLOR);
+    const auto mesh = std::make_shared<MeshSolidColor<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader);
+    Scene scene;
+    scene.SetRenderQueueEnabled(false);
+    for (size_t i = 0; i < objectCount; i++) {
+        scene.AddObject(std::make_shared<Shape<Vertex>>(mesh, glm::vec3(float(i % 100), float(i / 100), 50.0f)));
+    }
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    scene.Draw(camera);
+    glFinish();
+    double cpuMs = 0.0;
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
+        camera->SetPosition(glm::vec3(0.01f * float(frame), 0.0f, 5.0f));
+        Timer timer;
+        scene.Draw(camera);
+        cpuMs += timer.ElapsedMs();
+        glFinish();
+    }
+
+
+    shader->Bind();
+    // The shader has no u_View and u_Proj any more; u_Model takes the same glUniformMatrix4fv.
+    const UniformHandle model = shader->GetUniformHandle("u_Model");
+    const size_t callCount = objectCount * 10;
+    auto callNs = [&](auto&& call) {
+        Timer timer;
+        for (size_t i = 0; i < callCount; i++) {
+            call(i);
+        }
+        return 1e6 * timer.ElapsedMs() / callCount;
+    };
+    const double perDrawNs = callNs([&](size_t) {
+        const CameraUniforms uniforms = camera->GetUniforms();
+        shader->SetUniformMat4f(model, uniforms.view);
+        shader->SetUniformMat4f(model, uniforms.proj);
+    });
+    const double checkNs = callNs([&](size_t) { camera->UploadUniforms(); });
+    const double uploadNs = callNs([&](size_t i) {
+        camera->SetPosition(glm::vec3(0.001f * float(i), 0.0f, 5.0f));
+        camera->UploadUniforms();
+    });
+    glFinish();
+    const double savedMs = 1e-6 * (double(objectCount) * (perDrawNs - checkNs) - uploadNs);
+
+    std::cout << std::fixed << std::setprecision(2) << "[CameraUniforms] " << objectCount << " objects, camera moving\n"
+              << "  Scene::Draw: " << cpuMs / frameCount << " ms CPU/frame, " << 1e6 * cpuMs / frameCount / objectCount << " ns/draw\n"
+              << "  camera per draw: matrices + 2 uniforms " << perDrawNs << " ns before, block check " << checkNs
+              << " ns now; block upload " << uploadNs << " ns once per frame\n"
+              << "  saved: " << savedMs << " ms CPU/frame" << std::defaultfloat << std::endl;
+}
+
+/**
+ * Material upload bytes per frame for objectCount wireframe cubes drawn one by one (render queue off), ten per mesh,
+ * while changedShare of the meshes change color every frame. Each mesh has its own MaterialBuffer slot; the per-draw
+ * uniforms it replaces (u_Color, u_LineColor, u_LineWidth) would send their bytes for every draw.
+ */
+template <class Vertex>
+void BenchmarkMaterialUpload(size_t objectCount, float changedShare, unsigned int frameCount = 20) {
+    const Geometry<Vertex> cube(EBasicGeometry::CUBE);
+    const ShaderPtr shader = Shader::GetDefaultShader(EDefaultShader::SOLID_COLOR_WIREFRAME);
+    std::vector<MeshSolidColorWireframePtr<Vertex>> meshes;
+    for (size_t i = 0; i < objectCount / 10; i++) {
+        meshes.push_back(std::make_shared<MeshSolidColorWireframe<Vertex>>(cube.GetVertices(), cube.GetIndices(), shader));
+    }
+    Scene scene;
+    scene.SetRenderQueueEnabled(false);
+    for (size_t i = 0; i < objectCount; i++) {
+        scene.AddObject(std::make_shared<Shape<Vertex>>(meshes[i / 10], glm::vec3(float(i % 100), float(i / 100), 50.0f)));
+    }
+    CameraPtr camera = std::make_shared<Camera>(800, 800, glm::vec3(0.0f, 0.0f, 5.0f));
+    scene.Draw(camera);
+    glFinish();
+
+    MaterialBuffer& materials = MaterialBuffer::GetGlobal();
+    const size_t changedCount = static_cast<size_t>(changedShare * float(meshes.size()));
+    size_t next = 0;
+    double cpuMs = 0.0;
+    MaterialBuffer::Stats stats;
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
+        for (size_t i = 0; i < changedCount; i++, next++) {
+            meshes[next % meshes.size()]->SetColor(glm::vec4(float(frame % 7) / 7.0f, 0.5f, 0.5f, 1.0f));
+        }
+        materials.ResetStats();
+        Timer timer;
+        scene.Draw(camera);
+        cpuMs += timer.ElapsedMs();
+        glFinish();
+        stats.uploads += materials.GetStats().uploads;
+        stats.uploadedBytes += materials.GetStats().uploadedBytes;
+        stats.binds += materials.GetStats().binds;
+        stats.skippedBinds += materials.GetStats().skippedBinds;
+    }
+    const size_t uniformBytes = objectCount * (2 * sizeof(glm::vec4) + sizeof(float));
+
+    std::cout << std::fixed << std::setprecision(2) << "[MaterialUpload] " << objectCount << " objects, " << meshes.size() << " materials, "
+              << 100.0f * changedShare << "% changing per frame\n"
+              << "  Scene::Draw: " << cpuMs / frameCount << " ms CPU/frame\n"
+              << "  material buffer: " << stats.uploadedBytes / frameCount << " bytes/frame in " << stats.uploads / frameCount
+              << " uploads, " << stats.binds / frameCount << " binds, " << stats.skippedBinds / frameCount << " skipped\n"
+              << "  per-draw uniforms: " << uniformBytes << " bytes/frame in " << 3 * objectCount << " glUniform calls"
+              << std::defaultfloat << std::endl;
+}
+
+/**
+ * Matrix work per frame of a nodeCount node scene made of 100-node compound objects (a root, 9 children, 10 grandchildren
+ * each), where movingShare of the nodes, picked at random, get a new location every frame. All world matrices are read
+ * as drawing would; with TransformNode only the moved subtrees are recomputed. The reference recomputes every node's
+ * translation * rotation * scale and parent product each frame, as Shape did before the hierarchy.
+ */
+inline void BenchmarkTransformHierarchy(size_t nodeCount = 100000, float movingShare = 0.01f, unsigned int frameCount = 20) {
+    std::vector<TransformNode> nodes(nodeCount / 100 * 100);
+    // Parent index of each node, -1 for roots; parents come before their children.
+    std::vector<int> parents(nodes.size(), -1);
+    for (size_t root = 0; root < nodes.size(); root += 100) {
+        nodes[root].SetLocation(glm::vec3(float(root / 100 % 100), float(root / 10000), 0.0f));
+        for (size_t child = 0; child < 9; child++) {
+            const size_t childIndex = root + 1 + child;
+            nodes[childIndex].SetParent(&nodes[root]);
+            parents[childIndex] = int(root);
+            nodes[childIndex].SetLocation(glm::vec3(0.1f * float(child), 0.0f, 0.0f));
+            nodes[childIndex].SetRotation(10.0f * float(child), glm::vec3(0.0f, 1.0f, 0.0f));
+            for (size_t grandchild = 0; grandchild < 10; grandchild++) {
+                const size_t grandchildIndex = root + 10 + child * 10 + grandchild;
+                nodes[grandchildIndex].SetParent(&nodes[childIndex]);
+                parents[grandchildIndex] = int(childIndex);
+                nodes[grandchildIndex].SetLocation(glm::vec3(0.0f, 0.05f * float(grandchild), 0.0f));
+                nodes[grandchildIndex].SetScale(glm::vec3(0.5f));
+            }
+        }
+    }
+    std::mt19937 random(7);
+    std::uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+    const size_t movingCount = static_cast<size_t>(movingShare * float(nodes.size()));
+    auto moveNodes = [&](unsigned int frame) {
+        for (size_t i = 0; i < movingCount; i++) {
+            TransformNode& node = nodes[pick(random)];
+            node.SetLocation(node.GetLocation() + glm::vec3(0.0f, 0.0f, 0.01f * float(frame % 3) - 0.01f));
+        }
+    };
+    float checksum = 0.0f;
+    for (const TransformNode& node : nodes) {
+        checksum += node.GetWorldMatrix()[3][0];
+    }
+
+    double cachedMs = 0.0;
+    size_t recomputed = 0;
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
+        moveNodes(frame);
+        recomputed += std::count_if(nodes.begin(), nodes.end(), [](const TransformNode& node) { return node.IsWorldDirty(); });
+        Timer timer;
+        for (const TransformNode& node : nodes) {
+            checksum += node.GetWorldMatrix()[3][0];
+        }
+        cachedMs += timer.ElapsedMs();
+    }
+
+    std::vector<glm::mat4> translations(nodes.size()), rotations(nodes.size()), scales(nodes.size()), worlds(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        translations[i] = glm::translate(glm::mat4(1.0f), nodes[i].GetLocation());
+        rotations[i] = nodes[i].GetRotationMatrix();
+        scales[i] = glm::scale(glm::mat4(1.0f), nodes[i].GetScale());
+    }
+    double fullMs = 0.0;
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
+        Timer timer;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const glm::mat4 local = translations[i] * rotations[i] * scales[i];
+            worlds[i] = parents[i] < 0 ? local : worlds[parents[i]] * local;
+            checksum += worlds[i][3][0];
+        }
+        fullMs += timer.ElapsedMs();
+    }
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const glm::mat4& world = nodes[i].GetWorldMatrix();
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                maxDifference = std::max(maxDifference, std::abs(world[column][row] - worlds[i][column][row]));
+            }
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3) << "[TransformHierarchy] " << nodes.size() << " nodes, " << movingCount
+              << " moving per frame\n"
+              << "  recompute all: " << fullMs / frameCount << " ms/frame, " << nodes.size() << " nodes\n"
+              << "  dirty flags:   " << cachedMs / frameCount << " ms/frame, " << recomputed / frameCount << " nodes recomputed\n"
+              << "  max difference " << maxDifference << " (checksum " << checksum << ")" << std::defaultfloat << std::endl;
+}
+
+/**
+ * Run every render benchmark; false if a streamed load went over its resident budget or differed from LoadObj, or if
+ * Defragment corrupted a BufferArena range.
+ */
+inline bool RunRenderBenchmarks(const std::string& model = "res/models/dennis.obj") {
+    bool bPassed = BenchmarkObjStreaming<VertexNormal>(model, ObjStreamLoader<VertexNormal>::kDefaultBlockBytes, 0);
+    BenchmarkAsyncLoading<VertexNormal>(model);
+    for (size_t meshCount : {size_t(1000), size_t(10000), size_t(100000)}) {
+        bPassed = BenchmarkBufferArena<VertexNormal>(meshCount) && bPassed;
+    }
+    BenchmarkRenderQueue<VertexNormal>(10000, 100, 4);
+    BenchmarkInstancing<VertexNormal>(100000, 1);
+    BenchmarkInstancing<VertexNormal>(100000, 16);
+    BenchmarkShaderLibrary<VertexNormal>(1000);
+    BenchmarkProgramBinaryCache<VertexNormal>();
+    BenchmarkParallelShaderCompile();
+    BenchmarkUniformUpload<VertexNormal>(10000);
+    BenchmarkCameraUniforms<VertexNormal>(10000);
+    BenchmarkMaterialUpload<VertexNormal>(10000, 0.01f);
+    BenchmarkTransformHierarchy(100000, 0.01f);
+
+    // 1 GB of text holds ~9M positions and normals; with them resident the loader peaks around 310 MB.
+    const std::string synthetic = "res/models/synthetic_1gb.obj";
+    if (GeometryBenchmarks::WriteSyntheticObj(synthetic, size_t(1) << 30)) {
+        const size_t syntheticBudget = size_t(512) << 20;
+        bPassed = BenchmarkObjStreaming<VertexNormal>(synthetic, ObjStreamLoader<VertexNormal>::kDefaultBlockBytes, syntheticBudget) &&
+                  bPassed;
+        std::remove(synthetic.c_str());
+    }
+
+    const std::string syntheticAsync = "res/models/synthetic_128mb.obj";
+    if (GeometryBenchmarks::WriteSyntheticObj(syntheticAsync, size_t(128) << 20)) {
+        BenchmarkAsyncLoading<VertexNormal>(syntheticAsync);
+        std::remove(syntheticAsync.c_str());
+        std::remove(GeometryCacheUtils::GetCachePath(syntheticAsync, VertexBufferLayout::FromVertex<VertexNormal>(), 0).c_str());
+    }
+
+    if (!bPassed) {
+        std::cerr << "Render benchmarks FAILED: see the ObjStreaming and BufferArena results above" << std::endl;
+    }
+    return bPassed;
+}
+
+} // namespace RenderBenchmarks
@@ -0,0 +1,367 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+/** First-fit allocator of ranges in [0, capacity). Free ranges are kept sorted and merged with their neighbours. */
+class RangeAllocator {
+public:
+    explicit RangeAllocator(size_t capacity = 0) { Grow(capacity); }
+
+    /** First unit of count contiguous free units, or nullopt if no free range is large enough. */
+    std::optional<size_t> Allocate(size_t count);
+    void Free(size_t first, size_t count);
+    /** Add [GetCapacity(), capacity) to the free ranges. */
+    void Grow(size_t capacity);
+    /** Forget every allocation but [0, used), leaving one free range after it. */
+    void Reset(size_t used);
+
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetUsed() const { return m_Used; }
+    size_t GetLargestFree() const;
+    size_t GetFreeRangeCount() const { return m_FreeRanges.size(); }
+
+private:
+    // First unit to unit count.
+    std::map<size_t, size_t> m_FreeRanges;
+    size_t m_Capacity = 0;
+    size_t m_Used = 0;
+};
+
+inline std::optional<size_t> RangeAllocator::Allocate(size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it) {
+        const auto [first, freeCount] = *it;
+        if (freeCount < count) {
+            continue;
+        }
+        m_FreeRanges.erase(it);
+        if (freeCount > count) {
+            m_FreeRanges.emplace(first + count, freeCount - count);
+        }
+        m_Used += count;
+        return first;
+    }
+    return std::nullopt;
+}
+
+inline void RangeAllocator::Free(size_t first, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    m_Used -= count;
+    auto next = m_FreeRanges.lower_bound(first);
+    if (next != m_FreeRanges.end() && first + count == next->first) {
+        count += next->second;
+        next = m_FreeRanges.erase(next);
+    }
+    if (next != m_FreeRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == first) {
+            previous->second += count;
+            return;
+        }
+    }
+    m_FreeRanges.emplace_hint(next, first, count);
+}
+
+inline void RangeAllocator::Grow(size_t capacity) {
+    if (capacity <= m_Capacity) {
+        return;
+    }
+    const size_t added = capacity - m_Capacity;
+    // Free marks the range used first, so count it in before handing it back.
+    m_Used += added;
+    Free(m_Capacity, added);
+    m_Capacity = capacity;
+}
+
+inline void RangeAllocator::Reset(size_t used) {
+    m_FreeRanges.clear();
+    m_Used = used;
+    if (used < m_Capacity) {
+        m_FreeRanges.emplace(used, m_Capacity - used);
+    }
+}
+
+inline size_t RangeAllocator::GetLargestFree() const {
+    size_t largest = 0;
+    for (const auto& [first, count] : m_FreeRanges) {
+        largest = std::max(largest, count);
+    }
+    return largest;
+}
+
+/** Where one allocation of a BufferArena lives. Its indices are relative to firstVertex, see glDrawElementsBaseVertex. */
+struct BufferArenaRange {
+    size_t firstVertex = 0;
+    size_t vertexCount = 0;
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+};
+
+/**
+ * One vertex buffer, index buffer and vertex array shared by many meshes of the same vertex type. Each mesh gets a range
+ * of vertices and indices instead of three GL objects of its own, so drawing it needs no VAO switch and ranges of other
+ * meshes can be drawn from the same bindings.
+ * Allocations are addressed by handle, which stays valid when the arena grows or Defragment moves the ranges.
+ * Like the other GL wrappers the arena does not delete its buffers on destruction, see Delete.
+ */
+template <class Vertex>
+class BufferArena {
+public:
+    using Handle = uint32_t;
+
+    static constexpr size_t kDefaultVertexCapacity = size_t(1) << 16;
+    static constexpr size_t kDefaultIndexCapacity = size_t(1) << 18;
+
+    explicit BufferArena(size_t vertexCapacity = kDefaultVertexCapacity, size_t indexCapacity = kDefaultIndexCapacity);
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    /** Copy vertices and indices into free ranges, growing the buffers if there are none large enough. */
+    Handle Allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void Free(Handle handle);
+
+    /**
+     * Move the live ranges to the front of the buffers, in their current order, so the free space is one range at the end.
+     * Copies stay on the GPU; runs of ranges that are already adjacent are copied at once.
+     */
+    void Defragment();
+
+    const BufferArenaRange& GetRange(Handle handle) const { return m_Slots[handle].range; }
+
+    /** Bind the shared vertex array; every allocation is drawn from it. */
+    void Bind() const { m_VertexArray.Bind(); }
+    unsigned int GetVertexArrayID() const { return m_VertexArray.m_ID; }
+    void Delete() const;
+
+    /** The current buffers; they are replaced when the arena grows or defragments. */
+    const VertexBuffer<Vertex>& GetVertexBuffer() const { return m_VertexBuffer; }
+    const IndexBuffer& GetIndexBuffer() const { return m_IndexBuffer; }
+
+    size_t GetVertexCapacity() const { return m_VertexRanges.GetCapacity(); }
+    size_t GetIndexCapacity() const { return m_IndexRanges.GetCapacity(); }
+    size_t GetUsedVertices() const { return m_VertexRanges.GetUsed(); }
+    size_t GetUsedIndices() const { return m_IndexRanges.GetUsed(); }
+    size_t GetAllocationCount() const { return m_Slots.size() - m_FreeHandles.size(); }
+    /** Share of the free vertex space outside the largest free range: 0 after Defragment, near 1 when the holes are scattered. */
+    float GetFragmentation() const;
+
+    /** Arena for meshes that do not bring their own. It lives as long as the process, like the GL context. */
+    static BufferArena& GetGlobal() {
+        static BufferArena arena;
+        return arena;
+    }
+
+private:
+    struct Slot {
+        BufferArenaRange range;
+        bool bLive = false;
+    };
+
+    /** Replace the buffers with ones of the given capacities and copy the live ranges over, compacted to the front. */
+    void Reallocate(size_t vertexCapacity, size_t indexCapacity);
+
+    VertexArray<Vertex> m_VertexArray;
+    VertexBuffer<Vertex> m_VertexBuffer;
+    IndexBuffer m_IndexBuffer;
+    RangeAllocator m_VertexRanges;
+    RangeAllocator m_IndexRanges;
+    std::vector<Slot> m_Slots;
+    std::vector<Handle> m_FreeHandles;
+};
+
+template <class Vertex>
+BufferArena<Vertex>::BufferArena(size_t vertexCapacity, size_t indexCapacity)
+    // Creating the index buffer binds it to the current VAO, which has to be ours.
+    : m_IndexBuffer((m_VertexArray.Bind(), IndexBuffer())),
+      m_VertexRanges(vertexCapacity),
+      m_IndexRanges(indexCapacity) {
+    m_VertexBuffer.Allocate(vertexCapacity);
+    m_VertexArray.Bind();
+    m_IndexBuffer.Allocate(static_cast<unsigned int>(indexCapacity));
+    m_VertexArray.AddBuffer(m_VertexBuffer);
+}
+
+template <class Vertex>
+typename BufferArena<Vertex>::Handle BufferArena<Vertex>::Allocate(
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    std::optional<size_t> firstVertex = m_VertexRanges.Allocate(vertices.size());
+    std::optional<size_t> firstIndex = m_IndexRanges.Allocate(indices.size());
+    if (!firstVertex || !firstIndex) {
+        if (firstVertex) {
+            m_VertexRanges.Free(*firstVertex, vertices.size());
+        }
+        if (firstIndex) {
+            m_IndexRanges.Free(*firstIndex, indices.size());
+        }
+        // Doubling keeps the copies amortized; reallocating compacts, so the new ranges fit after the used ones.
+        Reallocate(std::max(2 * GetVertexCapacity(), GetUsedVertices() + vertices.size()),
+            std::max(2 * GetIndexCapacity(), GetUsedIndices() + indices.size()));
+        firstVertex = m_VertexRanges.Allocate(vertices.size());
+        firstIndex = m_IndexRanges.Allocate(indices.size());
+    }
+
+    Handle handle;
+    if (m_FreeHandles.empty()) {
+        handle = static_cast<Handle>(m_Slots.size());
+        m_Slots.emplace_back();
+    } else {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+    }
+    m_Slots[handle] = {{*firstVertex, vertices.size(), *firstIndex, indices.size()}, true};
+
+    if (!vertices.empty()) {
+        m_VertexBuffer.SetSubData(*firstVertex, vertices.data(), vertices.size());
+    }
+    if (!indices.empty()) {
+        m_VertexArray.Bind();
+        m_IndexBuffer.SetSubData(
+            static_cast<unsigned int>(*firstIndex), indices.data(), static_cast<unsigned int>(indices.size()));
+    }
+    return handle;
+}
+
+template <class Vertex>
+void BufferArena<Vertex>::Free(Handle handle) {
+    Slot& slot = m_Slots[handle];
+    m_VertexRanges.Free(slot.range.firstVertex, slot.range.vertexCount);
+    m_IndexRanges.Free(slot.range.firstIndex, slot.range.indexCount);
+    slot = {};
+    m_FreeHandles.push_back(handle);
+}
+
+template <class Vertex>
+void BufferArena<Vertex>::Defragment() {
+    Reallocate(GetVertexCapacity(), GetIndexCapacity());
+}
+
+template <class Vertex>
+void BufferArena<Vertex>::Reallocate(size_t vertexCapacity, size_t indexCapacity) {
+    VertexBuffer<Vertex> vertexBuffer;
+    vertexBuffer.Allocate(vertexCapacity);
+    m_VertexArray.Bind();
+    IndexBuffer indexBuffer;
+    indexBuffer.Allocate(static_cast<unsigned int>(indexCapacity));
+
+    // Copy the ranges selected by member from source to the front of target, in their current order, and update them.
+    auto compact = [this](GLuint source, GLuint target, size_t elementBytes, size_t BufferArenaRange::*first,
+                       size_t BufferArenaRange::*count) {
+        std::vector<BufferArenaRange*> ranges;
+        for (Slot& slot : m_Slots) {
+            if (slot.bLive && slot.range.*count > 0) {
+                ranges.push_back(&slot.range);
+            }
+        }
+        std::sort(ranges.begin(), ranges.end(), [first](const auto* a, const auto* b) { return a->*first < b->*first; });
+        glBindBuffer(GL_COPY_READ_BUFFER, source);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+        size_t used = 0;
+        for (size_t run = 0; run < ranges.size();) {
+            const size_t runFirst = ranges[run]->*first;
+            size_t runEnd = runFirst;
+            for (; run < ranges.size() && ranges[run]->*first == runEnd; run++) {
+                runEnd += ranges[run]->*count;
+                ranges[run]->*first = used + (ranges[run]->*first - runFirst);
+            }
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, runFirst * elementBytes, used * elementBytes,
+                (runEnd - runFirst) * elementBytes);
+            used += runEnd - runFirst;
+        }
+        return used;
+    };
+    const size_t usedVertices = compact(
+        m_VertexBuffer.m_ID, vertexBuffer.m_ID, sizeof(Vertex), &BufferArenaRange::firstVertex, &BufferArenaRange::vertexCount);
+    const size_t usedIndices = compact(
+        m_IndexBuffer.m_ID, indexBuffer.m_ID, sizeof(unsigned int), &BufferArenaRange::firstIndex, &BufferArenaRange::indexCount);
+
+    m_VertexBuffer.Delete();
+    m_IndexBuffer.Delete();
+    m_VertexBuffer = vertexBuffer;
+    m_IndexBuffer = indexBuffer;
+    m_VertexArray.Bind();
+    m_IndexBuffer.Bind();
+    m_VertexArray.AddBuffer(m_VertexBuffer);
+
+    m_VertexRanges.Grow(vertexCapacity);
+    m_VertexRanges.Reset(usedVertices);
+    m_IndexRanges.Grow(indexCapacity);
+    m_IndexRanges.Reset(usedIndices);
+}
+
+template <class Vertex>
+void BufferArena<Vertex>::Delete() const {
+    m_VertexArray.Delete();
+    m_VertexBuffer.Delete();
+    m_IndexBuffer.Delete();
+}
+
+template <class Vertex>
+float BufferArena<Vertex>::GetFragmentation() const {
+    const size_t freeVertices = GetVertexCapacity() - GetUsedVertices();
+    if (freeVertices == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(m_VertexRanges.GetLargestFree()) / static_cast<float>(freeVertices);
+}
+
+/** Owning reference to one allocation of a BufferArena, freed on destruction. */
+template <class Vertex>
+class BufferArenaAllocation {
+public:
+    BufferArenaAllocation() = default;
+
+    BufferArenaAllocation(BufferArena<Vertex>& arena, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+        : m_Arena(&arena),
+          m_Handle(arena.Allocate(vertices, indices)) {
+    }
+
+    BufferArenaAllocation(const BufferArenaAllocation&) = delete;
+    BufferArenaAllocation& operator=(const BufferArenaAllocation&) = delete;
+
+    BufferArenaAllocation(BufferArenaAllocation&& other) noexcept
+        : m_Arena(std::exchange(other.m_Arena, nullptr)),
+          m_Handle(other.m_Handle) {
+    }
+
+    BufferArenaAllocation& operator=(BufferArenaAllocation&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_Arena = std::exchange(other.m_Arena, nullptr);
+            m_Handle = other.m_Handle;
+        }
+        return *this;
+    }
+
+    ~BufferArenaAllocation() { Reset(); }
+
+    void Reset() {
+        if (m_Arena) {
+            m_Arena->Free(m_Handle);
+            m_Arena = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return m_Arena != nullptr; }
+
+    BufferArena<Vertex>& GetArena() const { return *m_Arena; }
+    const BufferArenaRange& GetRange() const { return m_Arena->GetRange(m_Handle); }
+
+private:
+    BufferArena<Vertex>* m_Arena = nullptr;
+    typename BufferArena<Vertex>::Handle m_Handle = 0;
+};
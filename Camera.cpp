@@ -1,6 +1,9 @@
 #include "Camera.h"
 
+#include <optional>
+
 #include "OGLRenderer.h"
+#include "UniformBuffer.h"
 #include "glm/gtc/matrix_transform.hpp"
 
 Camera::Camera(int width, int height, const glm::vec3& position)
@@ -9,14 +12,52 @@ Camera::Camera(int width, int height, const glm::vec3& position)
       m_Height(height) {
 }
 
-void Camera::Update(Shader& shader) {
-    glm::mat4 view = glm::mat4(1.0f);
-    glm::mat4 proj = glm::mat4(1.0f);
-    view = glm::lookAt(m_Position, m_Position + m_Orientation, m_UpVector);
-    proj = glm::perspective(glm::radians(m_FOV), (float)(m_Width / m_Height),
+namespace {
+// What the uniforms are computed from.
+struct CameraState {
+    glm::vec3 position, orientation, upVector;
+    int width, height;
+    float fov, nearPlane, farPlane;
+
+    bool operator==(const CameraState&) const = default;
+};
+
+// Created on first upload, when there is a GL context.
+std::optional<UniformBuffer<CameraUniforms>> GCameraBuffer;
+std::optional<CameraState> GUploadedState;
+} // namespace
+
+CameraUniforms Camera::GetUniforms() const {
+    CameraUniforms uniforms;
+    uniforms.view = glm::lookAt(m_Position, m_Position + m_Orientation, m_UpVector);
+    uniforms.proj = glm::perspective(glm::radians(m_FOV), (float)(m_Width / m_Height),
         m_NearPlane, m_FarPlane);
-    shader.SetUniformMat4f("u_Proj", proj);
-    shader.SetUniformMat4f("u_View", view);
+    uniforms.viewProj = uniforms.proj * uniforms.view;
+    uniforms.position = glm::vec4(m_Position, 1.0f);
+    uniforms.viewport = glm::vec4(m_Width, m_Height, m_NearPlane, m_FarPlane);
+    return uniforms;
+}
+
+bool Camera::UploadUniforms() const {
+    const CameraState state{m_Position, m_Orientation, m_UpVector, m_Width, m_Height, m_FOV, m_NearPlane, m_FarPlane};
+    if (GUploadedState == state) {
+        return false;
+    }
+    if (!GCameraBuffer) {
+        GCameraBuffer.emplace(static_cast<GLuint>(EUniformBlock::CAMERA));
+    }
+    GCameraBuffer->SetData(GetUniforms());
+    GUploadedState = state;
+    return true;
+}
+
+float Camera::GetScreenSize(const glm::vec3& center, float radius) const {
+    const float distance = glm::length(center - m_Position);
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    // The projected diameter over the viewport height at that distance.
+    return radius / (distance * glm::tan(glm::radians(m_FOV) * 0.5f));
 }
 
 void Camera::Inputs(GLFWwindow* window) {
@@ -11,6 +11,20 @@
 #include "Shader.h"
 using CameraPtr = std::shared_ptr<class Camera>;
 
+/**
+ * The "Camera" uniform block of the shaders (EUniformBlock::CAMERA), in std140 layout:
+ * layout(std140) uniform Camera { mat4 u_View; mat4 u_Proj; mat4 u_ViewProj; vec4 u_CameraPosition; vec4 u_Viewport; };
+ */
+struct CameraUniforms {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    // xyz, w = 1
+    glm::vec4 position;
+    // width, height, near plane, far plane
+    glm::vec4 viewport;
+};
+
 class Camera {
     glm::vec3 m_Position = glm::vec3(0.0f, 0.0f, 0.0f);
     glm::vec3 m_Orientation = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -33,7 +47,12 @@ public:
     Camera() = default;
     Camera(int width, int height, const glm::vec3& pos);
 
-    void Update(Shader& shader);
+    CameraUniforms GetUniforms() const;
+    /**
+     * Make the Camera uniform block hold this camera. Builds and uploads the matrices only when the camera moved or a
+     * different camera was uploaded last, so calling it for every draw costs a comparison. Returns whether it uploaded.
+     */
+    bool UploadUniforms() const;
     void Inputs(GLFWwindow* window);
 
     glm::vec3 GetPosition() const {
@@ -51,4 +70,9 @@ public:
     void SetOrientation(const glm::vec3& orientation) {
         m_Orientation = orientation;
     }
+
+    /**
+     * Fraction of the viewport height covered by a sphere in world space, 1 or more once the camera is inside it.
+     */
+    float GetScreenSize(const glm::vec3& center, float radius) const;
 };
@@ -1,9 +1,17 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cfloat>
+#include <limits>
 #include <vector>
 #include "VertexBuffer.h"
-#include <execution>
+#include "GeometryCache.h"
+#include "GeometryNormals.h"
+#include "GeometryOBJ.h"
+#include "GeometrySimplify.h"
+#include "GeometryVertexCache.h"
+#include "MappedFile.h"
 #include "Profile.h"
+#include "ThreadPool.h"
 
 enum class EBasicGeometry {
     NONE,
@@ -11,41 +19,23 @@ enum class EBasicGeometry {
     PYRAMID,
 };
 
-namespace GeometryOBJUtils {
-static constexpr auto kObjCustomHeader = "#Normalnyi obj 1.0";
-static constexpr auto kConvertedNamePostfix = "_a1";
-static constexpr auto kVertexCountPrefix = "#vcount";
-static constexpr auto kNormalCountPrefix = "#vncount";
-static constexpr auto kUVCountPrefix = "#vtcount";
-static constexpr auto kFaceCountPrefix = "#fcount";
-
-static void ConvertObjToCustom(const std::string& fileName) {
-    std::ifstream input(fileName);
-    assert(input.is_open());
-
-    std::string content((std::istreambuf_iterator(input)), std::istreambuf_iterator<char>());
-
-    const auto vertexNormalUVCount = std::count(std::execution::par_unseq, std::begin(content), std::end(content), 'v');
-    constexpr auto vertexCountDevisor = 2;
-    const auto vertexCount = vertexNormalUVCount / vertexCountDevisor;
-    const auto uvCount = vertexCount, normalCount = vertexCount;
-    const auto faceCount = std::count(std::execution::par_unseq, std::begin(content), std::end(content), 'f');
-    const std::string convertedName = fileName + kConvertedNamePostfix;
-    std::ofstream convertedFile(convertedName, std::ofstream::trunc);
-    convertedFile.clear();
-    convertedFile << kObjCustomHeader << "\n";
-
-    convertedFile << kVertexCountPrefix << " " << vertexCount << '\n';
-    convertedFile << kNormalCountPrefix << " " << normalCount << '\n';
-    convertedFile << kUVCountPrefix << " " << uvCount << '\n';
-    convertedFile << kFaceCountPrefix << " " << faceCount << '\n';
-
-    convertedFile << content;
-    convertedFile.close();
-
-    input.close();
-}
-} // namespace GeometryFormatUtils
+enum class EObjVertexMode {
+    // One vertex per "v" record. Corners sharing a position overwrite each other's normal, UVs are dropped.
+    SHARED_POSITIONS,
+    // One vertex per distinct (v, vt, vn) corner, so normal and UV seams are kept.
+    UNIQUE_CORNERS,
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+/** Axis-aligned; low > high on every axis when empty. */
+struct BoundingBox {
+    glm::vec3 low = glm::vec3(FLT_MAX);
+    glm::vec3 high = glm::vec3(-FLT_MAX);
+};
 
 template <class Vertex>
 class Geometry {
@@ -63,7 +53,27 @@ public:
     static Geometry GeneratePrism(unsigned int n, float height = 1.0f, float r = 1.0f);
     static Geometry GenerateSphere(float r = 1.0f, unsigned int sectorCount = 50, unsigned int stackCount = 50);
 
-    static Geometry<Vertex> LoadObj(const std::string& file, bool bUseCustomOBJ = true);
+    /**
+     * Load a Wavefront OBJ by memory-mapping it and tokenizing the mapped bytes in place.
+     * @param mode how face corners are turned into vertices.
+     * @param bUseBinaryCache load from / write to a ".a1bin" cache next to the file. @see GeometryCacheUtils
+     * A file that cannot be opened gives an empty geometry and no cache.
+     */
+    static Geometry<Vertex> LoadObj(
+        const std::string& file, EObjVertexMode mode = EObjVertexMode::SHARED_POSITIONS, bool bUseBinaryCache = true);
+    /**
+     * Parse OBJ text from [begin, end). Quads are split into two triangles, larger polygons are fan or ear-clip triangulated.
+     */
+    static Geometry<Vertex> ParseObj(const char* begin, const char* end, EObjVertexMode mode = EObjVertexMode::SHARED_POSITIONS);
+    /**
+     * Parse OBJ text split into line-aligned chunks on the pool. Produces the same geometry as ParseObj.
+     */
+    static Geometry<Vertex> ParseObjParallel(
+        const char* begin, const char* end, ThreadPool& pool, EObjVertexMode mode = EObjVertexMode::SHARED_POSITIONS);
+    /**
+     * Reference istringstream-based loader. Slow, kept to benchmark and validate LoadObj against.
+     */
+    static Geometry<Vertex> LoadObjStream(const std::string& file);
     void AddVertex(const Vertex& vertex) { m_Vertices.push_back(vertex); }
     void AddVertex(const glm::vec3& pos) { m_Vertices.emplace_back(pos); }
     void AddIndex(unsigned int index) { m_Indices.push_back(index); }
@@ -76,7 +86,49 @@ public:
     void SetPositions(const std::vector<Vertex>& vertices) { m_Vertices = vertices; };
     void SetIndices(const std::vector<unsigned int>& indices) { m_Indices = indices; };
 
-    void GenerateNormals(bool bFlatShading = false);
+    /**
+     * Recompute vertex normals from the triangles, in parallel on pool.
+     * Smooth normals sum the faces around each vertex weighted by weighting, starting from zero; flat shading gives every
+     * vertex the normal of the last face using it, which is only right for un-indexed meshes (see GenerateCreaseNormals).
+     * Faces are split into one contiguous range per pool thread.
+     */
+    void GenerateNormals(
+        bool bFlatShading = false, ENormalWeighting weighting = ENormalWeighting::AREA, ThreadPool& pool = ThreadPool::GetGlobal());
+    /**
+     * Normals that are smooth across edges whose faces meet at no more than creaseAngleDegrees and hard across the rest.
+     * Vertices on a hard edge are split, one copy per smoothing group around them, so no more vertices are added than
+     * the hard edges need; 0 degrees gives correct flat shading on indexed meshes. Returns the number of vertices added.
+     */
+    size_t GenerateCreaseNormals(
+        float creaseAngleDegrees, ENormalWeighting weighting = ENormalWeighting::AREA, ThreadPool& pool = ThreadPool::GetGlobal());
+    /**
+     * Reorder triangles for the post-transform vertex cache (Tipsify), optionally sort cache-friendly clusters so
+     * outward-facing ones draw first to reduce overdraw, then renumber vertices in order of first use for fetch locality.
+     * Rendering is unchanged apart from the draw order. @see GeometryVertexCacheUtils
+     */
+    void OptimizeVertexCache(unsigned int cacheSize = GeometryVertexCacheUtils::kDefaultCacheSize, bool bReduceOverdraw = true);
+
+    /**
+     * Decimated copy with at most targetTriangles triangles, fewer if collapses run out before maxError (a squared
+     * distance) is reached. Seams and open borders are kept; unreferenced vertices are dropped. @see GeometrySimplifyUtils
+     * @param resultError if set, receives the largest error of a collapse that was made.
+     */
+    Geometry Simplify(size_t targetTriangles, double maxError = DBL_MAX, double* resultError = nullptr) const;
+    /**
+     * LOD chain: level i has about triangleRatios[i] of this geometry's triangles, each level decimated from the
+     * previous one. Ratios must be decreasing; a leading 1 makes level 0 a plain copy.
+     */
+    std::vector<Geometry> GenerateLods(const std::vector<float>& triangleRatios, double maxError = DBL_MAX) const;
+    BoundingSphere GetBoundingSphere() const;
+    BoundingBox GetBoundingBox() const;
+    /** Transform positions by matrix and normals by its inverse transpose, renormalized. */
+    void Transform(const glm::mat4& matrix);
+
+    /**
+     * Reference serial implementation, kept to benchmark and validate GenerateNormals against.
+     * Accumulates onto the existing normals, so they should be zero for smooth shading.
+     */
+    void GenerateNormalsSerial(bool bFlatShading = false);
 
     std::vector<Vertex>& GetVertices() { return m_Vertices; };
     std::vector<unsigned int>& GetIndices() { return m_Indices; };
@@ -95,6 +147,20 @@ private:
     std::vector<Vertex> m_Vertices;
     std::vector<unsigned int> m_Indices;
 
+    /** OBJ records, with the faces kept as per-chunk lists of triangle corners. */
+    struct ObjData {
+        // One per "v" record, only the position is set.
+        std::vector<Vertex> vertices;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<GeometryOBJUtils::ObjFaceList> chunkFaces;
+    };
+
+    /** Parse [begin, end) into the presized arrays of data, starting at the record indices in cursor. */
+    static void ParseObjChunk(const char* begin, const char* end, GeometryOBJUtils::ObjRecordCounts cursor, ObjData& data,
+        GeometryOBJUtils::ObjFaceList& faces);
+    static Geometry<Vertex> BuildObjGeometry(ObjData& data, EObjVertexMode mode, ThreadPool* pool);
+    static Vertex MakeCornerVertex(const ObjData& data, const GeometryOBJUtils::ObjCorner& corner);
 };
 
 template <class Vertex>
@@ -110,7 +176,215 @@ void Geometry<Vertex>::MergeWith(Geometry& source) {
 }
 
 template <class Vertex>
-void Geometry<Vertex>::GenerateNormals(bool bFlatShading) {
+void Geometry<Vertex>::GenerateNormals(bool bFlatShading, ENormalWeighting weighting, ThreadPool& pool) {
+    if (Empty()) {
+        return;
+    }
+    GeometryNormalsUtils::GenerateNormals(m_Vertices.data(), m_Vertices.size(), m_Indices.data(), m_Indices.size(), bFlatShading,
+        weighting, pool, [this](size_t vertex) -> glm::vec3& { return m_Vertices[vertex].normal; });
+}
+
+template <class Vertex>
+size_t Geometry<Vertex>::GenerateCreaseNormals(float creaseAngleDegrees, ENormalWeighting weighting, ThreadPool& pool) {
+    using namespace GeometryNormalsUtils;
+    if (Empty()) {
+        return 0;
+    }
+    const size_t faceCount = m_Indices.size() / 3;
+    const size_t vertexCount = m_Vertices.size();
+
+    std::vector<glm::vec3> faceNormals(faceCount);
+    std::vector<glm::vec3> unitNormals(faceCount);
+    std::vector<float> cornerWeights(weighting == ENormalWeighting::ANGLE ? 3 * faceCount : 0);
+    constexpr size_t rangeFaces = 65536;
+    pool.ParallelFor((faceCount + rangeFaces - 1) / rangeFaces, [&](size_t range) {
+        const size_t first = range * rangeFaces;
+        ForEachFaceNormalBatch(m_Vertices.data(), m_Indices.data(), first, std::min(faceCount, first + rangeFaces), weighting, false,
+            [&](const FaceNormalBatch& batch) {
+                for (size_t i = 0; i < batch.count; i++) {
+                    const glm::vec3 normal = batch.Normal(i);
+                    faceNormals[batch.first + i] = normal;
+                    unitNormals[batch.first + i] = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+                }
+                if (weighting == ENormalWeighting::ANGLE) {
+                    std::copy_n(batch.cornerWeights, 3 * batch.count, cornerWeights.begin() + 3 * batch.first);
+                }
+            });
+    });
+
+    // The epsilon keeps coplanar faces, whose unit normals differ by rounding, smooth at 0 degrees. Degenerate faces have
+    // no direction; the splitter gives them the group of a neighbour.
+    constexpr float cosEpsilon = 1.0e-6f;
+    const float cosCrease = glm::cos(glm::radians(creaseAngleDegrees)) - cosEpsilon;
+    auto bSmooth = [&](unsigned int faceA, unsigned int faceB) { return glm::dot(unitNormals[faceA], unitNormals[faceB]) >= cosCrease; };
+    auto bDegenerate = [&](unsigned int face) { return glm::dot(unitNormals[face], unitNormals[face]) == 0.0f; };
+
+    VertexCornerAdjacency adjacency;
+    adjacency.Build(m_Indices.data(), m_Indices.size(), vertexCount);
+    constexpr size_t rangeVertices = 16384;
+    auto forEachVertexRange = [&](auto&& task) {
+        pool.ParallelFor((vertexCount + rangeVertices - 1) / rangeVertices,
+            [&](size_t range) { task(range * rangeVertices, std::min(vertexCount, (range + 1) * rangeVertices)); });
+    };
+
+    // Pass 1: smoothing group of every corner, and the number of copies every vertex needs.
+    std::vector<unsigned int> cornerGroups(m_Indices.size());
+    std::vector<unsigned int> firstCopy(vertexCount + 1, 0);
+    forEachVertexRange([&](size_t first, size_t last) {
+        CreaseFanSplitter splitter;
+        std::vector<unsigned int> groups;
+        for (size_t vertex = first; vertex < last; vertex++) {
+            const unsigned int* cornersBegin = adjacency.corners.data() + adjacency.offsets[vertex];
+            const unsigned int* cornersEnd = adjacency.corners.data() + adjacency.offsets[vertex + 1];
+            const size_t groupCount = splitter.Split(
+                m_Indices.data(), static_cast<unsigned int>(vertex), cornersBegin, cornersEnd, bSmooth, bDegenerate, groups);
+            for (size_t i = 0; i < groups.size(); i++) {
+                cornerGroups[cornersBegin[i]] = groups[i];
+            }
+            firstCopy[vertex + 1] = groupCount > 1 ? static_cast<unsigned int>(groupCount - 1) : 0;
+        }
+    });
+    // The copies of a vertex are appended in vertex order, so the result does not depend on the thread count.
+    firstCopy[0] = static_cast<unsigned int>(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        firstCopy[vertex + 1] += firstCopy[vertex];
+    }
+    m_Vertices.resize(firstCopy[vertexCount]);
+
+    // Pass 2: every vertex fills its own copies, normals and corners. The first group keeps the original vertex.
+    forEachVertexRange([&](size_t first, size_t last) {
+        std::vector<glm::vec3> groupSums;
+        for (size_t vertex = first; vertex < last; vertex++) {
+            const unsigned int* cornersBegin = adjacency.corners.data() + adjacency.offsets[vertex];
+            const unsigned int* cornersEnd = adjacency.corners.data() + adjacency.offsets[vertex + 1];
+            if (cornersBegin == cornersEnd) {
+                continue;
+            }
+            groupSums.assign(1 + firstCopy[vertex + 1] - firstCopy[vertex], glm::vec3(0.0f));
+            for (const unsigned int* corner = cornersBegin; corner < cornersEnd; corner++) {
+                const glm::vec3& faceNormal = faceNormals[*corner / 3];
+                groupSums[cornerGroups[*corner]] += weighting == ENormalWeighting::ANGLE ? faceNormal * cornerWeights[*corner] : faceNormal;
+            }
+            auto vertexOf = [&](unsigned int group) {
+                return group == 0 ? static_cast<unsigned int>(vertex) : firstCopy[vertex] + group - 1;
+            };
+            for (unsigned int group = 0; group < groupSums.size(); group++) {
+                Vertex& target = m_Vertices[vertexOf(group)];
+                if (group > 0) {
+                    target = m_Vertices[vertex];
+                }
+                const glm::vec3& sum = groupSums[group];
+                target.normal = glm::dot(sum, sum) > 0.0f ? glm::normalize(sum) : glm::vec3(0.0f);
+            }
+            for (const unsigned int* corner = cornersBegin; corner < cornersEnd; corner++) {
+                m_Indices[*corner] = vertexOf(cornerGroups[*corner]);
+            }
+        }
+    });
+    return m_Vertices.size() - vertexCount;
+}
+
+template <class Vertex>
+void Geometry<Vertex>::OptimizeVertexCache(unsigned int cacheSize, bool bReduceOverdraw) {
+    using namespace GeometryVertexCacheUtils;
+    if (Empty()) {
+        return;
+    }
+    std::vector<size_t> deadEnds;
+    m_Indices = TipsifyOrder(m_Indices, m_Vertices.size(), cacheSize, &deadEnds);
+    if (bReduceOverdraw) {
+        m_Indices = ReduceOverdraw(m_Indices, m_Vertices, deadEnds, cacheSize);
+    }
+
+    const std::vector<unsigned int> remap = FetchOrderRemap(m_Indices, m_Vertices.size());
+    std::vector<Vertex> vertices(m_Vertices.size());
+    for (size_t vertex = 0; vertex < m_Vertices.size(); vertex++) {
+        vertices[remap[vertex]] = std::move(m_Vertices[vertex]);
+    }
+    m_Vertices = std::move(vertices);
+    for (unsigned int& index : m_Indices) {
+        index = remap[index];
+    }
+}
+
+template <class Vertex>
+Geometry<Vertex> Geometry<Vertex>::Simplify(size_t targetTriangles, double maxError, double* resultError) const {
+    GeometrySimplifyUtils::SimplifyResult simplified = GeometrySimplifyUtils::Simplify(m_Vertices, m_Indices, targetTriangles, maxError);
+    if (resultError) {
+        *resultError = simplified.maxError;
+    }
+
+    // Keep the surviving vertices in their original order.
+    constexpr unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(m_Vertices.size(), unused);
+    for (const unsigned int index : simplified.indices) {
+        remap[index] = 0;
+    }
+    Geometry<Vertex> geometry;
+    for (size_t vertex = 0; vertex < m_Vertices.size(); vertex++) {
+        if (remap[vertex] != unused) {
+            remap[vertex] = static_cast<unsigned int>(geometry.m_Vertices.size());
+            geometry.m_Vertices.push_back(m_Vertices[vertex]);
+        }
+    }
+    for (unsigned int& index : simplified.indices) {
+        index = remap[index];
+    }
+    geometry.m_Indices = std::move(simplified.indices);
+    return geometry;
+}
+
+template <class Vertex>
+std::vector<Geometry<Vertex>> Geometry<Vertex>::GenerateLods(const std::vector<float>& triangleRatios, double maxError) const {
+    std::vector<Geometry<Vertex>> lods;
+    lods.reserve(triangleRatios.size());
+    const size_t triangleCount = GetNumIndices() / 3;
+    for (const float ratio : triangleRatios) {
+        const Geometry<Vertex>& source = lods.empty() ? *this : lods.back();
+        const auto targetTriangles = static_cast<size_t>(std::max(0.0f, ratio) * triangleCount);
+        lods.push_back(targetTriangles >= source.GetNumIndices() / 3 ? source : source.Simplify(targetTriangles, maxError));
+    }
+    return lods;
+}
+
+template <class Vertex>
+BoundingSphere Geometry<Vertex>::GetBoundingSphere() const {
+    if (m_Vertices.empty()) {
+        return {};
+    }
+    const BoundingBox box = GetBoundingBox();
+    BoundingSphere sphere;
+    sphere.center = (box.low + box.high) * 0.5f;
+    for (const Vertex& vertex : m_Vertices) {
+        sphere.radius = std::max(sphere.radius, glm::length(vertex.position - sphere.center));
+    }
+    return sphere;
+}
+
+template <class Vertex>
+BoundingBox Geometry<Vertex>::GetBoundingBox() const {
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+    for (const Vertex& vertex : m_Vertices) {
+        low = glm::min(low, vertex.position);
+        high = glm::max(high, vertex.position);
+    }
+    return {low, high};
+}
+
+template <class Vertex>
+void Geometry<Vertex>::Transform(const glm::mat4& matrix) {
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+    for (Vertex& vertex : m_Vertices) {
+        vertex.position = glm::vec3(matrix * glm::vec4(vertex.position, 1.0f));
+        if constexpr (requires { vertex.normal; }) {
+            const glm::vec3 normal = normalMatrix * vertex.normal;
+            vertex.normal = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+        }
+    }
+}
+
+template <class Vertex>
+void Geometry<Vertex>::GenerateNormalsSerial(bool bFlatShading) {
     if (Empty()) {
         return;
     }
@@ -184,22 +458,223 @@ Geometry<Vertex> Geometry<Vertex>::GenerateSphere(float r, unsigned int sectorCo
 }
 
 
-// TODO: Profile.
 template <class Vertex>
-Geometry<Vertex> Geometry<Vertex>::LoadObj(const std::string& file, bool bUseCustomOBJ) {
+Geometry<Vertex> Geometry<Vertex>::LoadObj(const std::string& file, EObjVertexMode mode, bool bUseBinaryCache) {
+    MappedFile mappedFile(file);
+    if (!mappedFile.IsOpen()) {
+        std::cerr << "LoadObj: cannot open " << file << std::endl;
+        return {};
+    }
+    LOG_DURATION("LoadOBJ");
+
+    const VertexBufferLayout layout = VertexBufferLayout::FromVertex<Vertex>();
+    const auto source = GeometryCacheUtils::GetSourceInfo(file);
+    const auto cacheVariant = static_cast<uint32_t>(mode);
+    const std::string cacheFile = GeometryCacheUtils::GetCachePath(file, layout, cacheVariant);
+    if (bUseBinaryCache) {
+        GeometryCacheUtils::CachedMesh cache;
+        if (cache.Open(cacheFile, source, mappedFile.Data(), sizeof(Vertex), layout, cacheVariant)) {
+            const auto* vertices = static_cast<const Vertex*>(cache.Vertices());
+            Geometry<Vertex> geometry(std::vector<Vertex>(vertices, vertices + cache.GetVertexCount()),
+                std::vector<unsigned int>(cache.Indices(), cache.Indices() + cache.GetIndexCount()));
+            if (cache.IsWriteTimeStale()) {
+                cache.Close();
+                GeometryCacheUtils::UpdateSourceWriteTime(cacheFile, source.writeTime);
+            }
+            return geometry;
+        }
+    }
+
+    // Below this size spinning up the chunks costs more than it saves.
+    constexpr size_t parallelParseMinBytes = 4 << 20;
+    Geometry<Vertex> geometry = mappedFile.Size() >= parallelParseMinBytes
+        ? ParseObjParallel(mappedFile.begin(), mappedFile.end(), ThreadPool::GetGlobal(), mode)
+        : ParseObj(mappedFile.begin(), mappedFile.end(), mode);
+    if (bUseBinaryCache) {
+        GeometryCacheUtils::WriteCache(
+            cacheFile, source, mappedFile.Data(), geometry.GetVertices(), geometry.GetIndices(), layout, cacheVariant);
+    }
+    return geometry;
+}
+
+template <class Vertex>
+Geometry<Vertex> Geometry<Vertex>::ParseObj(const char* begin, const char* end, EObjVertexMode mode) {
+    const GeometryOBJUtils::ObjRecordCounts counts = GeometryOBJUtils::CountRecords(begin, end);
+    ObjData data;
+    data.vertices.resize(counts.positions);
+    data.normals.resize(counts.normals);
+    data.uvs.resize(counts.uvs);
+    data.chunkFaces.resize(1);
+    // A quad emits 6 corners, assume most faces are triangles.
+    data.chunkFaces[0].triangles.reserve(3 * counts.faces);
+    ParseObjChunk(begin, end, {}, data, data.chunkFaces[0]);
+    return BuildObjGeometry(data, mode, nullptr);
+}
+
+template <class Vertex>
+Geometry<Vertex> Geometry<Vertex>::ParseObjParallel(const char* begin, const char* end, ThreadPool& pool, EObjVertexMode mode) {
+    using namespace GeometryOBJUtils;
+    // Several chunks per thread even out chunks that are mostly faces against chunks that are mostly vertices.
+    constexpr size_t chunksPerThread = 4;
+    const std::vector<const char*> chunks = SplitAtLines(begin, end, pool.GetThreadCount() * chunksPerThread);
+    const size_t chunkCount = chunks.size() - 1;
+
+    // Pass 1: count records per chunk. The exclusive prefix sum gives every chunk its first global record index,
+    // which places its records in the shared arrays and resolves relative face indices.
+    std::vector<ObjRecordCounts> chunkBase(chunkCount + 1);
+    pool.ParallelFor(chunkCount, [&](size_t chunk) { chunkBase[chunk + 1] = CountRecords(chunks[chunk], chunks[chunk + 1]); });
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        chunkBase[chunk + 1] += chunkBase[chunk];
+    }
+
+    // Pass 2: parse every chunk into the shared arrays; faces go to per-chunk face lists.
+    ObjData data;
+    data.vertices.resize(chunkBase[chunkCount].positions);
+    data.normals.resize(chunkBase[chunkCount].normals);
+    data.uvs.resize(chunkBase[chunkCount].uvs);
+    data.chunkFaces.resize(chunkCount);
+    pool.ParallelFor(chunkCount, [&](size_t chunk) {
+        data.chunkFaces[chunk].triangles.reserve(3 * (chunkBase[chunk + 1].faces - chunkBase[chunk].faces));
+        ParseObjChunk(chunks[chunk], chunks[chunk + 1], chunkBase[chunk], data, data.chunkFaces[chunk]);
+    });
+
+    // Pass 3: triangulate n-gons and stitch the triangle lists together.
+    return BuildObjGeometry(data, mode, &pool);
+}
+
+template <class Vertex>
+void Geometry<Vertex>::ParseObjChunk(const char* begin, const char* end, GeometryOBJUtils::ObjRecordCounts cursor, ObjData& data,
+    GeometryOBJUtils::ObjFaceList& faces) {
+    using namespace GeometryOBJUtils;
+    std::vector<ObjCorner> face;
+    for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+        switch (ClassifyRecord(p, end)) {
+            case EObjRecord::POSITION: {
+                glm::vec3& position = data.vertices[cursor.positions++].position;
+                p = ParseFloat(p, end, position.x);
+                p = ParseFloat(p, end, position.y);
+                p = ParseFloat(p, end, position.z);
+                break;
+            }
+            case EObjRecord::NORMAL: {
+                glm::vec3& normal = data.normals[cursor.normals++];
+                p = ParseFloat(p, end, normal.x);
+                p = ParseFloat(p, end, normal.y);
+                p = ParseFloat(p, end, normal.z);
+                break;
+            }
+            case EObjRecord::UV: {
+                glm::vec2& uv = data.uvs[cursor.uvs++];
+                p = ParseFloat(p, end, uv.x);
+                p = ParseFloat(p, end, uv.y);
+                break;
+            }
+            case EObjRecord::FACE: {
+                p = ParseFaceCorners(p, end, cursor, face);
+                faces.AddFace(face);
+                break;
+            }
+            case EObjRecord::OTHER: break;
+        }
+    }
+}
+
+template <class Vertex>
+Vertex Geometry<Vertex>::MakeCornerVertex(const ObjData& data, const GeometryOBJUtils::ObjCorner& corner) {
+    Vertex vertex = data.vertices[corner.position];
+    if constexpr (requires { vertex.normal; }) {
+        if (corner.normal != GeometryOBJUtils::kAbsentIndex) {
+            vertex.normal = data.normals[corner.normal];
+        }
+    }
+    if constexpr (requires { vertex.texUV; }) {
+        if (corner.uv != GeometryOBJUtils::kAbsentIndex) {
+            vertex.texUV = data.uvs[corner.uv];
+        }
+    }
+    return vertex;
+}
+
+template <class Vertex>
+Geometry<Vertex> Geometry<Vertex>::BuildObjGeometry(ObjData& data, EObjVertexMode mode, ThreadPool* pool) {
+    using namespace GeometryOBJUtils;
+    const size_t chunkCount = data.chunkFaces.size();
+    auto forEachChunk = [&](auto&& task) {
+        if (pool) {
+            pool->ParallelFor(chunkCount, task);
+        } else {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                task(chunk);
+            }
+        }
+    };
+
+    // Every position is known now, so concave n-gons can replace their parse-time fan.
+    forEachChunk([&](size_t chunk) {
+        ObjFaceList& faces = data.chunkFaces[chunk];
+        PolygonTriangulator triangulator;
+        auto positionOf = [&](const ObjCorner& corner) { return data.vertices[corner.position].position; };
+        for (const ObjPolygon& polygon : faces.polygons) {
+            triangulator.Triangulate(&faces.polygonCorners[polygon.firstCorner], polygon.cornerCount, positionOf,
+                &faces.triangles[polygon.firstTriangleCorner]);
+        }
+    });
+
+    std::vector<size_t> indexOffsets(chunkCount + 1, 0);
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        indexOffsets[chunk + 1] = indexOffsets[chunk] + data.chunkFaces[chunk].triangles.size();
+    }
+
+    Geometry<Vertex> geometry;
+    geometry.m_Indices.resize(indexOffsets[chunkCount]);
+    if (mode == EObjVertexMode::SHARED_POSITIONS) {
+        forEachChunk([&](size_t chunk) {
+            const auto& triangles = data.chunkFaces[chunk].triangles;
+            for (size_t i = 0; i < triangles.size(); i++) {
+                geometry.m_Indices[indexOffsets[chunk] + i] = triangles[i].position;
+            }
+        });
+        // In file order, so the last corner referencing a position decides its normal.
+        for (const auto& faces : data.chunkFaces) {
+            for (const auto& corner : faces.triangles) {
+                if (corner.normal != kAbsentIndex) {
+                    data.vertices[corner.position].normal = data.normals[corner.normal];
+                }
+            }
+        }
+        geometry.m_Vertices = std::move(data.vertices);
+    } else {
+        CornerIndexMap cornerIndices(data.vertices.size());
+        geometry.m_Vertices.reserve(data.vertices.size());
+        size_t i = 0;
+        for (const auto& faces : data.chunkFaces) {
+            for (const auto& corner : faces.triangles) {
+                bool bInserted = false;
+                geometry.m_Indices[i++] =
+                    cornerIndices.FindOrInsert(corner, static_cast<unsigned int>(geometry.m_Vertices.size()), bInserted);
+                if (bInserted) {
+                    geometry.m_Vertices.push_back(MakeCornerVertex(data, corner));
+                }
+            }
+        }
+    }
+
+    constexpr bool bLogStat = true;
+    if (bLogStat) {
+        std::cout << "verts: " << geometry.GetNumVertices() << " inds " << geometry.GetNumIndices() << " norms " << data.normals.size()
+            << " uvs " << data.uvs.size() << std::endl;
+    }
+    return geometry;
+}
+
+template <class Vertex>
+Geometry<Vertex> Geometry<Vertex>::LoadObjStream(const std::string& file) {
 
     std::ifstream fin(file, std::ifstream::in);
     assert(fin.is_open());
     std::string objHeader;
     std::getline(fin, objHeader);
-    bUseCustomOBJ = false;
-    if (bUseCustomOBJ) {
-        if (objHeader != GeometryOBJUtils::kObjCustomHeader) {
-            GeometryOBJUtils::ConvertObjToCustom(file);
-            return LoadObj(file + GeometryOBJUtils::kConvertedNamePostfix);
-        }
-    }
-    LOG_DURATION("LoadOBJ");
+    LOG_DURATION("LoadOBJStream");
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<glm::vec2> vertexUVs;
@@ -213,23 +688,7 @@ Geometry<Vertex> Geometry<Vertex>::LoadObj(const std::string& file, bool bUseCus
 
         istream >> header;
 
-        if (header == GeometryOBJUtils::kVertexCountPrefix) {
-            size_t vertexCount;
-            istream >> vertexCount;
-            vertices.reserve(vertexCount);
-        } else if (header == GeometryOBJUtils::kNormalCountPrefix) {
-            size_t vnCount;
-            istream >> vnCount;
-            vertexNormals.reserve(vnCount);
-        } else if (header == GeometryOBJUtils::kUVCountPrefix) {
-            size_t uvCount;
-            istream >> uvCount;
-            vertexUVs.reserve(uvCount);
-        } else if (header == GeometryOBJUtils::kFaceCountPrefix) {
-            size_t indexCount;
-            istream >> indexCount;
-            indices.reserve(indexCount * 2);
-        } else if (header == "v") {
+        if (header == "v") {
             Vertex vertex{};
             istream >> vertex.position.x >> vertex.position.y >> vertex.position.z;
             vertices.push_back(vertex);
@@ -302,10 +761,12 @@ Geometry<Vertex> Geometry<Vertex>::LoadObj(const std::string& file, bool bUseCus
                     }
                 }
 
-                // Link quad
+                // Link quad as (0, 1, 2), (0, 2, 3), keeping the winding
                 if (i == 3) {
+                    const unsigned int last = indices.back();
+                    indices.back() = indices[indices.size() - 4];
                     indices.push_back(indices[indices.size() - 2]);
-                    indices.push_back(indices[indices.size() - 5]);
+                    indices.push_back(last);
                 }
             }
         }
@@ -0,0 +1,232 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "MappedFile.h"
+#include "VertexBufferLayout.h"
+
+/**
+ * ".a1bin" binary mesh cache written next to a source OBJ.
+ *
+ * Layout: A1BinHeader, layoutElementCount x A1BinLayoutElement, padding to kDataAlignment,
+ * vertexCount x vertexStride bytes of vertices, indexCount x uint32 indices.
+ * Vertices and indices are the exact arrays Geometry holds, so a valid cache is mapped and copied, never parsed.
+ */
+namespace GeometryCacheUtils {
+static constexpr char kMagic[4] = {'A', '1', 'B', 'N'};
+static constexpr uint32_t kVersion = 4;
+static constexpr auto kExtension = ".a1bin";
+static constexpr size_t kDataAlignment = 16;
+
+struct A1BinHeader {
+    char magic[4];
+    uint32_t version;
+    // Source OBJ identity. mtime and size are checked first, the hash only when they disagree.
+    uint64_t sourceSize;
+    int64_t sourceWriteTime;
+    uint64_t sourceHash;
+    // Loader settings that change the produced arrays, e.g. EObjVertexMode.
+    uint32_t variant;
+    uint32_t vertexStride;
+    uint32_t layoutElementCount;
+    uint32_t reserved;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+};
+
+struct A1BinLayoutElement {
+    uint32_t count;
+    uint32_t type;
+    uint32_t normalized;
+};
+
+struct SourceInfo {
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+};
+
+/** 64-bit hash over 8-byte words; only used to tell whether a source file really changed. */
+inline uint64_t HashBytes(const char* data, size_t size) {
+    constexpr uint64_t prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+}
+
+inline SourceInfo GetSourceInfo(const std::string& file) {
+    std::error_code error;
+    SourceInfo info;
+    info.size = std::filesystem::file_size(file, error);
+    info.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(file, error).time_since_epoch().count());
+    return info;
+}
+
+inline std::vector<A1BinLayoutElement> DescribeLayout(const VertexBufferLayout& layout) {
+    std::vector<A1BinLayoutElement> elements;
+    for (const auto& element : layout.GetElements()) {
+        elements.push_back({element.count, element.type, element.normalized});
+    }
+    return elements;
+}
+
+/**
+ * Cache file for a source OBJ, vertex layout and loader variant. Both are part of the name so loading
+ * one OBJ with several vertex types or modes does not make the caches overwrite each other.
+ */
+inline std::string GetCachePath(const std::string& sourceFile, const VertexBufferLayout& layout, uint32_t variant) {
+    const auto elements = DescribeLayout(layout);
+    const uint64_t layoutHash =
+        HashBytes(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(A1BinLayoutElement)) + variant;
+    std::filesystem::path path(sourceFile);
+    path.replace_extension();
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "_%08x", static_cast<uint32_t>(layoutHash ^ (layoutHash >> 32)));
+    return path.string() + suffix + kExtension;
+}
+
+inline size_t GetDataOffset(uint32_t layoutElementCount) {
+    const size_t headerSize = sizeof(A1BinHeader) + layoutElementCount * sizeof(A1BinLayoutElement);
+    return (headerSize + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+/**
+ * Read-only view of a mapped cache. Vertices() and Indices() point into the mapping and can be
+ * uploaded with glBufferData as they are.
+ */
+class CachedMesh {
+public:
+    /**
+     * Map cacheFile and validate it against the source OBJ and the expected vertex layout.
+     * @param sourceData the mapped source, only hashed when size or mtime do not match. May be null.
+     */
+    bool Open(const std::string& cacheFile, const SourceInfo& source, const char* sourceData, uint32_t vertexStride,
+        const VertexBufferLayout& layout, uint32_t variant);
+
+    /**
+     * Whether the last Open matched the source by hash because its mtime differed. Rewrite the mtime with
+     * UpdateSourceWriteTime once the cache is closed, so later loads do not hash the source again.
+     */
+    bool IsWriteTimeStale() const { return m_bWriteTimeStale; }
+    void Close() { m_File.Close(); }
+
+    const void* Vertices() const { return m_File.Data() + GetDataOffset(m_Header.layoutElementCount); }
+    const uint32_t* Indices() const {
+        return reinterpret_cast<const uint32_t*>(static_cast<const char*>(Vertices()) + m_Header.vertexCount * m_Header.vertexStride);
+    }
+    size_t GetVertexCount() const { return m_Header.vertexCount; }
+    size_t GetIndexCount() const { return m_Header.indexCount; }
+
+private:
+    MappedFile m_File;
+    A1BinHeader m_Header{};
+    bool m_bWriteTimeStale = false;
+};
+
+inline bool CachedMesh::Open(const std::string& cacheFile, const SourceInfo& source, const char* sourceData, uint32_t vertexStride,
+    const VertexBufferLayout& layout, uint32_t variant) {
+    m_bWriteTimeStale = false;
+    if (!m_File.Open(cacheFile) || m_File.Size() < sizeof(A1BinHeader)) {
+        return false;
+    }
+    std::memcpy(&m_Header, m_File.Data(), sizeof(A1BinHeader));
+    if (std::memcmp(m_Header.magic, kMagic, sizeof(kMagic)) != 0 || m_Header.version != kVersion || m_Header.vertexStride != vertexStride
+        || m_Header.variant != variant) {
+        return false;
+    }
+
+    const auto expectedLayout = DescribeLayout(layout);
+    if (m_Header.layoutElementCount != expectedLayout.size()
+        || m_File.Size() != GetDataOffset(m_Header.layoutElementCount) + m_Header.vertexCount * m_Header.vertexStride
+        + m_Header.indexCount * sizeof(uint32_t)) {
+        return false;
+    }
+    if (std::memcmp(m_File.Data() + sizeof(A1BinHeader), expectedLayout.data(), expectedLayout.size() * sizeof(A1BinLayoutElement)) != 0) {
+        return false;
+    }
+
+    if (m_Header.sourceSize != source.size) {
+        return false;
+    }
+    if (m_Header.sourceWriteTime != source.writeTime) {
+        // Touched or copied, but possibly unchanged.
+        m_bWriteTimeStale = sourceData && m_Header.sourceHash == HashBytes(sourceData, source.size);
+        return m_bWriteTimeStale;
+    }
+    return true;
+}
+
+/** Overwrite the source mtime in the header of a closed cacheFile, after its source was found unchanged by hash. */
+inline bool UpdateSourceWriteTime(const std::string& cacheFile, int64_t writeTime) {
+    std::fstream file(cacheFile, std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.seekp(offsetof(A1BinHeader, sourceWriteTime));
+    file.write(reinterpret_cast<const char*>(&writeTime), sizeof(writeTime));
+    return static_cast<bool>(file);
+}
+
+/**
+ * Write the cache through a temporary file, so a crash never leaves a truncated cache behind.
+ */
+template <class Vertex>
+bool WriteCache(const std::string& cacheFile, const SourceInfo& source, const char* sourceData, const std::vector<Vertex>& vertices,
+    const std::vector<unsigned int>& indices, const VertexBufferLayout& layout, uint32_t variant) {
+    static_assert(std::is_trivially_copyable_v<Vertex>, "Cached vertices are written and read as raw bytes");
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t));
+
+    const auto elements = DescribeLayout(layout);
+    A1BinHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sourceSize = source.size;
+    header.sourceWriteTime = source.writeTime;
+    header.sourceHash = sourceData ? HashBytes(sourceData, source.size) : 0;
+    header.variant = variant;
+    header.vertexStride = sizeof(Vertex);
+    header.layoutElementCount = static_cast<uint32_t>(elements.size());
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+
+    const std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream out(tempFile, std::ofstream::binary | std::ofstream::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(A1BinLayoutElement));
+        const char padding[kDataAlignment] = {};
+        out.write(padding, GetDataOffset(header.layoutElementCount) - sizeof(header) - elements.size() * sizeof(A1BinLayoutElement));
+        out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+        out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(unsigned int));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempFile, cacheFile, error);
+    if (error) {
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+    return true;
+}
+} // namespace GeometryCacheUtils
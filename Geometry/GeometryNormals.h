@@ -0,0 +1,402 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_NORMALS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+enum class ENormalWeighting {
+    // Sum of raw face normals, their length is twice the triangle area.
+    AREA,
+    // Sum of unit face normals scaled by the triangle's angle at the vertex; independent of how a surface is tessellated.
+    ANGLE,
+};
+
+/**
+ * Building blocks of Geometry::GenerateNormals: face normals computed in SoA batches of kFaceBatch triangles.
+ * With SSE, positions of four faces are loaded as rows and transposed in registers, so cross products and
+ * normalization run four faces at a time without staging the positions in memory.
+ */
+namespace GeometryNormalsUtils {
+// Triangles per batch; a multiple of the 4 SSE lanes.
+static constexpr size_t kFaceBatch = 64;
+
+/** Normals of faces [first, first + count), SoA. cornerWeights (3 per face) is only filled for ENormalWeighting::ANGLE. */
+struct FaceNormalBatch {
+    size_t first = 0;
+    size_t count = 0;
+    float x[kFaceBatch], y[kFaceBatch], z[kFaceBatch];
+    float cornerWeights[3 * kFaceBatch];
+
+    glm::vec3 Normal(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+};
+
+/** Scales count lanes to unit length; zero-length (degenerate) normals stay zero. */
+inline void NormalizeBatch(float* nx, float* ny, float* nz, size_t count) {
+    size_t i = 0;
+#ifdef GEOMETRY_NORMALS_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(nx + i), y = _mm_loadu_ps(ny + i), z = _mm_loadu_ps(nz + i);
+        const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        const __m128 bNonZero = _mm_cmpgt_ps(lengthSquared, zero);
+        const __m128 length = _mm_sqrt_ps(lengthSquared);
+        // Division by a zero length yields NaN in masked-out lanes, the and drops them.
+        _mm_storeu_ps(nx + i, _mm_and_ps(bNonZero, _mm_div_ps(x, length)));
+        _mm_storeu_ps(ny + i, _mm_and_ps(bNonZero, _mm_div_ps(y, length)));
+        _mm_storeu_ps(nz + i, _mm_and_ps(bNonZero, _mm_div_ps(z, length)));
+    }
+#endif
+    for (; i < count; i++) {
+        const float lengthSquared = nx[i] * nx[i] + ny[i] * ny[i] + nz[i] * nz[i];
+        const float length = std::sqrt(lengthSquared);
+        nx[i] = lengthSquared > 0.0f ? nx[i] / length : 0.0f;
+        ny[i] = lengthSquared > 0.0f ? ny[i] / length : 0.0f;
+        nz[i] = lengthSquared > 0.0f ? nz[i] / length : 0.0f;
+    }
+}
+
+/** Position of a vertex, or the element itself when positions are a separate stream (GeometrySoA). */
+template <class Vertex>
+const glm::vec3& PositionOf(const Vertex& vertex) {
+    return vertex.position;
+}
+
+inline const glm::vec3& PositionOf(const glm::vec3& position) {
+    return position;
+}
+
+/** Angle between u and v; atan2 stays accurate for nearly degenerate corners where acos does not. */
+inline float CornerAngle(const glm::vec3& u, const glm::vec3& v) {
+    return std::atan2(glm::length(glm::cross(u, v)), glm::dot(u, v));
+}
+
+#ifdef GEOMETRY_NORMALS_SSE
+/** Position of vertex as (x, y, z, unspecified); reads the 16 bytes at the start of the vertex when it has them. */
+template <class Vertex>
+__m128 LoadPosition(const Vertex& vertex) {
+    static_assert(offsetof(Vertex, position) == 0);
+    if constexpr (sizeof(Vertex) >= 4 * sizeof(float)) {
+        return _mm_loadu_ps(&vertex.position.x);
+    } else {
+        return _mm_setr_ps(vertex.position.x, vertex.position.y, vertex.position.z, 0.0f);
+    }
+}
+
+// 12 bytes: reading 16 could run past the end of the stream.
+inline __m128 LoadPosition(const glm::vec3& position) {
+    return _mm_setr_ps(position.x, position.y, position.z, 0.0f);
+}
+
+/** Raw normals of the 4 faces starting at face, transposed to SoA in registers; same operation order as glm::cross. */
+template <class Vertex>
+void CrossFaces4(const Vertex* vertices, const unsigned int* face, float* nx, float* ny, float* nz) {
+    __m128 ax = LoadPosition(vertices[face[0]]), ay = LoadPosition(vertices[face[3]]), az = LoadPosition(vertices[face[6]]),
+           aw = LoadPosition(vertices[face[9]]);
+    __m128 bx = LoadPosition(vertices[face[1]]), by = LoadPosition(vertices[face[4]]), bz = LoadPosition(vertices[face[7]]),
+           bw = LoadPosition(vertices[face[10]]);
+    __m128 cx = LoadPosition(vertices[face[2]]), cy = LoadPosition(vertices[face[5]]), cz = LoadPosition(vertices[face[8]]),
+           cw = LoadPosition(vertices[face[11]]);
+    _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+    _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+    _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+    const __m128 ux = _mm_sub_ps(bx, ax), uy = _mm_sub_ps(by, ay), uz = _mm_sub_ps(bz, az);
+    const __m128 vx = _mm_sub_ps(cx, ax), vy = _mm_sub_ps(cy, ay), vz = _mm_sub_ps(cz, az);
+    _mm_storeu_ps(nx, _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(vy, uz)));
+    _mm_storeu_ps(ny, _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(vz, ux)));
+    _mm_storeu_ps(nz, _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(vx, uy)));
+}
+#endif
+
+/**
+ * Compute the normals of faces [firstFace, lastFace) a batch at a time and pass every batch to handler.
+ * bNormalize makes them unit length, otherwise they are the raw cross products (twice the triangle area long).
+ * ANGLE weighting always normalizes and also fills the corner angles.
+ */
+template <class Vertex, class Handler>
+void ForEachFaceNormalBatch(const Vertex* vertices, const unsigned int* indices, size_t firstFace, size_t lastFace,
+    ENormalWeighting weighting, bool bNormalize, Handler&& handler) {
+    FaceNormalBatch batch;
+    for (batch.first = firstFace; batch.first < lastFace; batch.first += kFaceBatch) {
+        batch.count = std::min(kFaceBatch, lastFace - batch.first);
+        const unsigned int* faces = indices + 3 * batch.first;
+        size_t i = 0;
+#ifdef GEOMETRY_NORMALS_SSE
+        for (; i + 4 <= batch.count; i += 4) {
+            CrossFaces4(vertices, faces + 3 * i, batch.x + i, batch.y + i, batch.z + i);
+        }
+#endif
+        for (; i < batch.count; i++) {
+            const glm::vec3& positionA = PositionOf(vertices[faces[3 * i]]);
+            const glm::vec3 normal =
+                glm::cross(PositionOf(vertices[faces[3 * i + 1]]) - positionA, PositionOf(vertices[faces[3 * i + 2]]) - positionA);
+            batch.x[i] = normal.x;
+            batch.y[i] = normal.y;
+            batch.z[i] = normal.z;
+        }
+        if (bNormalize || weighting == ENormalWeighting::ANGLE) {
+            NormalizeBatch(batch.x, batch.y, batch.z, batch.count);
+        }
+        if (weighting == ENormalWeighting::ANGLE) {
+            for (i = 0; i < batch.count; i++) {
+                const glm::vec3& positionA = PositionOf(vertices[faces[3 * i]]);
+                const glm::vec3& positionB = PositionOf(vertices[faces[3 * i + 1]]);
+                const glm::vec3& positionC = PositionOf(vertices[faces[3 * i + 2]]);
+                batch.cornerWeights[3 * i] = CornerAngle(positionB - positionA, positionC - positionA);
+                batch.cornerWeights[3 * i + 1] = CornerAngle(positionC - positionB, positionA - positionB);
+                batch.cornerWeights[3 * i + 2] = glm::pi<float>() - batch.cornerWeights[3 * i] - batch.cornerWeights[3 * i + 1];
+            }
+        }
+        handler(static_cast<const FaceNormalBatch&>(batch));
+    }
+}
+
+/** CSR list of the triangle corners (positions in the index array) using each vertex, in ascending order. */
+struct VertexCornerAdjacency {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> corners;
+
+    void Build(const unsigned int* indices, size_t indexCount, size_t vertexCount) {
+        offsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; i++) {
+            offsets[indices[i] + 1]++;
+        }
+        for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+        corners.resize(indexCount);
+        std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++) {
+            corners[cursor[indices[i]]++] = static_cast<unsigned int>(i);
+        }
+    }
+};
+
+/**
+ * Smooth or flat vertex normals of the triangles in indices, in parallel on pool; the body of Geometry::GenerateNormals,
+ * shared with GeometrySoA. vertices are read for their positions (see PositionOf), normalOf(vertex) is the normal to
+ * write, so the normals can live in the vertices or in a stream of their own.
+ * Smooth normals sum the faces around each vertex weighted by weighting, starting from zero; flat shading gives every
+ * vertex the normal of the last face using it. Faces are split into one contiguous range per pool thread.
+ */
+template <class Vertex, class NormalOf>
+void GenerateNormals(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, bool bFlatShading,
+    ENormalWeighting weighting, ThreadPool& pool, NormalOf&& normalOf) {
+    // Below this many faces per thread, splitting costs more than it saves.
+    constexpr size_t minRangeFaces = 65536;
+    const size_t faceCount = indexCount / 3;
+    const size_t rangeCount = std::clamp<size_t>(faceCount / minRangeFaces, 1, pool.GetThreadCount());
+    auto faceRange = [&](size_t range) { return std::make_pair(faceCount * range / rangeCount, faceCount * (range + 1) / rangeCount); };
+    auto forEachVertexRange = [&](auto&& task) {
+        pool.ParallelFor(rangeCount, [&](size_t range) { task(vertexCount * range / rangeCount, vertexCount * (range + 1) / rangeCount); });
+    };
+
+    if (bFlatShading) {
+        // The last face using a vertex sets its normal; recording it first lets faces write in any order.
+        std::vector<unsigned int> lastFace(vertexCount, std::numeric_limits<unsigned int>::max());
+        for (size_t i = 0; i < 3 * faceCount; i++) {
+            lastFace[indices[i]] = static_cast<unsigned int>(i / 3);
+        }
+        pool.ParallelFor(rangeCount, [&](size_t range) {
+            const auto [first, last] = faceRange(range);
+            ForEachFaceNormalBatch(vertices, indices, first, last, weighting, true, [&](const FaceNormalBatch& batch) {
+                for (size_t i = 0; i < batch.count; i++) {
+                    const unsigned int face = static_cast<unsigned int>(batch.first + i);
+                    for (size_t corner = 3 * face; corner < 3 * face + 3; corner++) {
+                        if (lastFace[indices[corner]] == face) {
+                            normalOf(indices[corner]) = batch.Normal(i);
+                        }
+                    }
+                }
+            });
+        });
+        return;
+    }
+
+    // add(corner, normal) with the weighted face normal of every corner, corner being its position in indices.
+    auto addFaces = [&](size_t first, size_t last, auto&& add) {
+        ForEachFaceNormalBatch(vertices, indices, first, last, weighting, false, [&](const FaceNormalBatch& batch) {
+            for (size_t i = 0; i < batch.count; i++) {
+                const glm::vec3 normal = batch.Normal(i);
+                for (size_t corner = 3 * i; corner < 3 * i + 3; corner++) {
+                    add(3 * batch.first + corner, weighting == ENormalWeighting::ANGLE ? normal * batch.cornerWeights[corner] : normal);
+                }
+            }
+        });
+    };
+    if (rangeCount == 1) {
+        forEachVertexRange([&](size_t first, size_t last) {
+            for (size_t vertex = first; vertex < last; vertex++) {
+                normalOf(vertex) = glm::vec3(0.0f);
+            }
+        });
+        addFaces(0, faceCount, [&](size_t corner, const glm::vec3& normal) { normalOf(indices[corner]) += normal; });
+    } else {
+        // Face ranges store the weighted normal of every corner, then every vertex gathers its corners through the vertex
+        // to corner adjacency: no two threads add to the same normal, and the scratch memory grows with the mesh, not with
+        // the thread count. Corners are gathered in ascending order, so the sums are the same as with a single range.
+        std::vector<glm::vec3> cornerNormals(3 * faceCount);
+        pool.ParallelFor(rangeCount, [&](size_t range) {
+            const auto [first, last] = faceRange(range);
+            addFaces(first, last, [&](size_t corner, const glm::vec3& normal) { cornerNormals[corner] = normal; });
+        });
+        VertexCornerAdjacency adjacency;
+        adjacency.Build(indices, 3 * faceCount, vertexCount);
+        forEachVertexRange([&](size_t first, size_t last) {
+            for (size_t vertex = first; vertex < last; vertex++) {
+                glm::vec3 sum(0.0f);
+                for (unsigned int i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++) {
+                    sum += cornerNormals[adjacency.corners[i]];
+                }
+                normalOf(vertex) = sum;
+            }
+        });
+    }
+    forEachVertexRange([&](size_t first, size_t last) {
+        for (size_t vertex = first; vertex < last; vertex++) {
+            const glm::vec3 sum = normalOf(vertex);
+            // Vertices used by no face, or only by degenerate ones, are left at zero instead of NaN.
+            normalOf(vertex) = glm::dot(sum, sum) > 0.0f ? glm::normalize(sum) : glm::vec3(0.0f);
+        }
+    });
+}
+
+/**
+ * Splits the fan of triangles around one vertex into smoothing groups: two triangles share a group if a chain of
+ * triangles connects them in which every consecutive pair shares an edge at the vertex and bSmooth(faceA, faceB) holds.
+ * Degenerate triangles (bDegenerate(face)) have no direction: they are left out of the chains, so a sliver cannot join
+ * the groups on both sides of a crease, and then join the group of a neighbour.
+ * Reused across vertices so its scratch arrays are allocated once.
+ */
+class CreaseFanSplitter {
+public:
+    /**
+     * Fills groups with the group of every corner in [cornersBegin, cornersEnd), numbered in order of first appearance,
+     * and returns the number of groups.
+     */
+    template <class IsSmooth, class IsDegenerate>
+    size_t Split(const unsigned int* indices, unsigned int vertex, const unsigned int* cornersBegin, const unsigned int* cornersEnd,
+        IsSmooth&& bSmooth, IsDegenerate&& bDegenerate, std::vector<unsigned int>& groups) {
+        const size_t count = cornersEnd - cornersBegin;
+        m_Parent.resize(count);
+        m_bDegenerate.resize(count);
+        m_Edges.clear();
+        for (unsigned int i = 0; i < count; i++) {
+            m_Parent[i] = i;
+            m_bDegenerate[i] = bDegenerate(cornersBegin[i] / 3);
+            const unsigned int face = cornersBegin[i] / 3;
+            for (unsigned int corner = 3 * face; corner < 3 * face + 3; corner++) {
+                if (indices[corner] != vertex) {
+                    m_Edges.emplace_back(indices[corner], i);
+                }
+            }
+        }
+        // Triangles sharing an edge at the vertex share its other end, so they end up next to each other.
+        std::sort(m_Edges.begin(), m_Edges.end());
+        for (size_t runBegin = 0, runEnd = 0; runBegin < m_Edges.size(); runBegin = runEnd) {
+            while (runEnd < m_Edges.size() && m_Edges[runEnd].first == m_Edges[runBegin].first) {
+                runEnd++;
+            }
+            for (size_t a = runBegin; a < runEnd; a++) {
+                for (size_t b = a + 1; b < runEnd; b++) {
+                    const unsigned int localA = m_Edges[a].second, localB = m_Edges[b].second;
+                    if (!m_bDegenerate[localA] && !m_bDegenerate[localB] && bSmooth(cornersBegin[localA] / 3, cornersBegin[localB] / 3)) {
+                        m_Parent[Find(localA)] = Find(localB);
+                    }
+                }
+            }
+        }
+        AttachDegenerate(count);
+
+        groups.resize(count);
+        size_t groupCount = 0;
+        m_GroupOfRoot.assign(count, kNoGroup);
+        for (unsigned int i = 0; i < count; i++) {
+            unsigned int& group = m_GroupOfRoot[Find(i)];
+            if (group == kNoGroup) {
+                group = static_cast<unsigned int>(groupCount++);
+            }
+            groups[i] = group;
+        }
+        return groupCount;
+    }
+
+private:
+    static constexpr unsigned int kNoGroup = ~0u;
+
+    /**
+     * Puts every degenerate triangle, still alone in its set, into the set of a triangle sharing an edge at the vertex,
+     * passing through chains of degenerate ones; the rest go with the first proper triangle, or together if there is none.
+     * Each is attached once as a leaf, so it never links two sets.
+     */
+    void AttachDegenerate(size_t count) {
+        m_bAttached.assign(count, false);
+        size_t pending = 0;
+        unsigned int firstProper = kNoGroup;
+        for (unsigned int i = 0; i < count; i++) {
+            m_bAttached[i] = !m_bDegenerate[i];
+            pending += m_bDegenerate[i];
+            if (!m_bDegenerate[i] && firstProper == kNoGroup) {
+                firstProper = i;
+            }
+        }
+        for (bool bProgress = pending > 0; bProgress;) {
+            bProgress = false;
+            for (size_t runBegin = 0, runEnd = 0; runBegin < m_Edges.size(); runBegin = runEnd) {
+                while (runEnd < m_Edges.size() && m_Edges[runEnd].first == m_Edges[runBegin].first) {
+                    runEnd++;
+                }
+                for (size_t a = runBegin; a < runEnd; a++) {
+                    const unsigned int degenerate = m_Edges[a].second;
+                    if (m_bAttached[degenerate]) {
+                        continue;
+                    }
+                    for (size_t b = runBegin; b < runEnd; b++) {
+                        const unsigned int neighbour = m_Edges[b].second;
+                        if (neighbour != degenerate && m_bAttached[neighbour]) {
+                            m_Parent[degenerate] = Find(neighbour);
+                            m_bAttached[degenerate] = true;
+                            pending--;
+                            bProgress = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        for (unsigned int i = 0; i < count && pending > 0; i++) {
+            if (!m_bAttached[i]) {
+                const unsigned int target = firstProper != kNoGroup ? firstProper : 0;
+                m_Parent[i] = i == target ? i : Find(target);
+                m_bAttached[i] = true;
+                pending--;
+            }
+        }
+    }
+
+    unsigned int Find(unsigned int i) {
+        while (m_Parent[i] != i) {
+            i = m_Parent[i] = m_Parent[m_Parent[i]];
+        }
+        return i;
+    }
+
+    std::vector<unsigned int> m_Parent;
+    std::vector<unsigned int> m_GroupOfRoot;
+    std::vector<bool> m_bDegenerate;
+    std::vector<bool> m_bAttached;
+    // (other vertex of an edge at the vertex, local triangle), two per triangle.
+    std::vector<std::pair<unsigned int, unsigned int>> m_Edges;
+};
+} // namespace GeometryNormalsUtils
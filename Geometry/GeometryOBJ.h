@@ -0,0 +1,514 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Allocation-free tokenizer for Wavefront OBJ text.
+ * Every scanner takes the current position and the end of the buffer and returns the position after the consumed token,
+ * so it can walk a memory-mapped file directly.
+ */
+namespace GeometryOBJUtils {
+
+/** One corner of an "f" record. Indices are as written in the file: 1-based, negative is relative, 0 means absent. */
+struct ObjFaceCorner {
+    int position = 0;
+    int uv = 0;
+    int normal = 0;
+};
+
+inline bool IsDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline bool IsInlineSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+inline bool IsLineEnd(char c) {
+    return c == '\n' || c == '\r' || c == '#';
+}
+
+inline const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && IsInlineSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/** Returns the first character of the next line. */
+inline const char* SkipLine(const char* p, const char* end) {
+    const void* newLine = std::memchr(p, '\n', end - p);
+    return newLine ? static_cast<const char*>(newLine) + 1 : end;
+}
+
+inline const char* ParseInt(const char* p, const char* end, int& out) {
+    bool bNegative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        bNegative = *p == '-';
+        ++p;
+    }
+    int value = 0;
+    while (p < end && IsDigit(*p)) {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    out = bNegative ? -value : value;
+    return p;
+}
+
+inline double Pow10(int exponent) {
+    // Powers up to 1e22 are exactly representable, so dividing by them rounds correctly.
+    static constexpr double kExactPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+        1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (exponent <= 22) {
+        return kExactPowers[exponent];
+    }
+    return std::pow(10.0, exponent);
+}
+
+/** Parses [+-]digits[.digits][(e|E)[+-]digits]. Leading spaces are skipped. */
+inline const char* ParseFloat(const char* p, const char* end, float& out) {
+    p = SkipSpaces(p, end);
+    bool bNegative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        bNegative = *p == '-';
+        ++p;
+    }
+
+    // Up to 19 significant digits fit into the mantissa; the rest only shift the exponent.
+    constexpr int kMaxDigits = 19;
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    while (p < end && IsDigit(*p)) {
+        if (significantDigits < kMaxDigits) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significantDigits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && IsDigit(*p)) {
+            if (significantDigits < kMaxDigits) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significantDigits += mantissa != 0;
+                exponent--;
+            }
+            ++p;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        int explicitExponent = 0;
+        p = ParseInt(p + 1, end, explicitExponent);
+        exponent += explicitExponent;
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        value /= Pow10(-exponent);
+    } else if (exponent > 0) {
+        value *= Pow10(exponent);
+    }
+    out = static_cast<float>(bNegative ? -value : value);
+    return p;
+}
+
+/** Parses one "v", "v/vt", "v//vn" or "v/vt/vn" token. Leading spaces are skipped. */
+inline const char* ParseFaceCorner(const char* p, const char* end, ObjFaceCorner& corner) {
+    corner = {};
+    p = ParseInt(SkipSpaces(p, end), end, corner.position);
+    if (p < end && *p == '/') {
+        ++p;
+        if (p < end && *p != '/') {
+            p = ParseInt(p, end, corner.uv);
+        }
+        if (p < end && *p == '/') {
+            p = ParseInt(p + 1, end, corner.normal);
+        }
+    }
+    return p;
+}
+
+/** True if there is another token before the end of the current line. */
+inline bool HasMoreTokens(const char*& p, const char* end) {
+    p = SkipSpaces(p, end);
+    return p < end && !IsLineEnd(*p);
+}
+
+/** Converts an OBJ index (1-based or negative relative) into a 0-based one. Returns false if it is absent or out of range. */
+inline bool ResolveIndex(int objIndex, size_t count, unsigned int& outIndex) {
+    long long resolved = objIndex < 0 ? static_cast<long long>(count) + objIndex : static_cast<long long>(objIndex) - 1;
+    if (objIndex == 0 || resolved < 0 || resolved >= static_cast<long long>(count)) {
+        return false;
+    }
+    outIndex = static_cast<unsigned int>(resolved);
+    return true;
+}
+
+enum class EObjRecord { OTHER, POSITION, NORMAL, UV, FACE };
+
+/** Identifies the record at the start of a line and moves p past its keyword. */
+inline EObjRecord ClassifyRecord(const char*& p, const char* end) {
+    p = SkipSpaces(p, end);
+    if (p + 1 >= end) {
+        return EObjRecord::OTHER;
+    }
+    if (p[0] == 'v') {
+        if (IsInlineSpace(p[1])) {
+            p += 1;
+            return EObjRecord::POSITION;
+        }
+        if (p[1] == 'n') {
+            p += 2;
+            return EObjRecord::NORMAL;
+        }
+        if (p[1] == 't') {
+            p += 2;
+            return EObjRecord::UV;
+        }
+    } else if (p[0] == 'f' && IsInlineSpace(p[1])) {
+        p += 1;
+        return EObjRecord::FACE;
+    }
+    return EObjRecord::OTHER;
+}
+
+struct ObjRecordCounts {
+    size_t positions = 0;
+    size_t normals = 0;
+    size_t uvs = 0;
+    size_t faces = 0;
+
+    ObjRecordCounts& operator+=(const ObjRecordCounts& other) {
+        positions += other.positions;
+        normals += other.normals;
+        uvs += other.uvs;
+        faces += other.faces;
+        return *this;
+    }
+};
+
+/** Counts records without parsing their values. */
+inline ObjRecordCounts CountRecords(const char* begin, const char* end) {
+    ObjRecordCounts counts;
+    for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+        switch (ClassifyRecord(p, end)) {
+            case EObjRecord::POSITION: counts.positions++;
+                break;
+            case EObjRecord::NORMAL: counts.normals++;
+                break;
+            case EObjRecord::UV: counts.uvs++;
+                break;
+            case EObjRecord::FACE: counts.faces++;
+                break;
+            case EObjRecord::OTHER: break;
+        }
+    }
+    return counts;
+}
+
+/**
+ * Splits [begin, end) into at most chunkCount ranges that start at line beginnings.
+ * Returns the chunk boundaries: front() == begin, back() == end.
+ */
+inline std::vector<const char*> SplitAtLines(const char* begin, const char* end, size_t chunkCount) {
+    std::vector<const char*> boundaries{begin};
+    const size_t size = end - begin;
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char* target = begin + size * i / chunkCount;
+        if (target <= boundaries.back()) {
+            continue;
+        }
+        const char* lineStart = SkipLine(target - 1, end);
+        if (lineStart >= end) {
+            break;
+        }
+        if (lineStart > boundaries.back()) {
+            boundaries.push_back(lineStart);
+        }
+    }
+    boundaries.push_back(end);
+    return boundaries;
+}
+
+/** Marks an absent uv or normal in ObjCorner. */
+static constexpr unsigned int kAbsentIndex = ~0u;
+
+/** A face corner with resolved 0-based indices into the position, uv and normal arrays. */
+struct ObjCorner {
+    unsigned int position;
+    unsigned int uv;
+    unsigned int normal;
+
+    bool operator==(const ObjCorner& other) const {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+/**
+ * Parses the corners of an "f" record (p points past the keyword) into the reusable corners buffer.
+ * counts holds the numbers of records read so far, used to resolve relative indices.
+ * Stops at the first corner whose position does not resolve; unresolvable uvs and normals are kAbsentIndex.
+ */
+inline const char* ParseFaceCorners(const char* p, const char* end, const ObjRecordCounts& counts, std::vector<ObjCorner>& corners) {
+    corners.clear();
+    while (HasMoreTokens(p, end)) {
+        ObjFaceCorner token;
+        p = ParseFaceCorner(p, end, token);
+        ObjCorner corner{kAbsentIndex, kAbsentIndex, kAbsentIndex};
+        if (!ResolveIndex(token.position, counts.positions, corner.position)) {
+            break;
+        }
+        ResolveIndex(token.uv, counts.uvs, corner.uv);
+        ResolveIndex(token.normal, counts.normals, corner.normal);
+        corners.push_back(corner);
+    }
+    return p;
+}
+
+/** Number of triangle corners an "f" record (p points past the keyword) is split into: 3 * (corners - 2). */
+inline size_t CountTriangleCorners(const char* p, const char* end) {
+    size_t corners = 0;
+    while (HasMoreTokens(p, end)) {
+        ObjFaceCorner token;
+        p = ParseFaceCorner(p, end, token);
+        corners++;
+    }
+    return corners >= 3 ? 3 * (corners - 2) : 0;
+}
+
+/** A face with 5+ corners, kept until the positions it references are known. */
+struct ObjPolygon {
+    size_t firstCorner;
+    size_t cornerCount;
+    // Where its cornerCount - 2 triangles start in ObjFaceList::triangles.
+    size_t firstTriangleCorner;
+};
+
+/**
+ * Triangle corners of a run of faces.
+ * N-gons are fan-triangulated while parsing, because positions referenced by the face may not be parsed yet;
+ * they are listed in polygons so PolygonTriangulator can redo the concave ones afterwards.
+ */
+struct ObjFaceList {
+    std::vector<ObjCorner> triangles;
+    std::vector<ObjPolygon> polygons;
+    std::vector<ObjCorner> polygonCorners;
+
+    /** Appends the triangles of a face. Quads are split as (0, 1, 2), (0, 2, 3), the fan of larger polygons, keeping the winding. */
+    void AddFace(const std::vector<ObjCorner>& face);
+};
+
+inline void ObjFaceList::AddFace(const std::vector<ObjCorner>& face) {
+    if (face.size() < 3) {
+        return;
+    }
+    if (face.size() == 3) {
+        triangles.insert(triangles.end(), {face[0], face[1], face[2]});
+        return;
+    }
+    // Link quad
+    if (face.size() == 4) {
+        triangles.insert(triangles.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+        return;
+    }
+    polygons.push_back({polygonCorners.size(), face.size(), triangles.size()});
+    polygonCorners.insert(polygonCorners.end(), face.begin(), face.end());
+    for (size_t i = 1; i + 1 < face.size(); i++) {
+        triangles.insert(triangles.end(), {face[0], face[i], face[i + 1]});
+    }
+}
+
+/**
+ * Triangulates planar polygons: a fan when the polygon is convex, ear clipping otherwise.
+ * The scratch arrays are kept between calls, so a reused triangulator stops allocating once it has seen its largest polygon.
+ */
+class PolygonTriangulator {
+public:
+    /**
+     * Writes the count - 2 triangles of polygon to triangles, keeping the winding of the polygon.
+     * @param positionOf maps an ObjCorner to its glm::vec3 position.
+     */
+    template <class PositionOf>
+    void Triangulate(const ObjCorner* polygon, size_t count, PositionOf&& positionOf, ObjCorner* triangles);
+
+private:
+    static float Cross(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+    bool IsEar(size_t prev, size_t cur, size_t next) const;
+
+    // The polygon projected onto its dominant plane, counter-clockwise.
+    std::vector<glm::vec2> m_Points;
+    // Indices of the corners not clipped yet, in polygon order.
+    std::vector<unsigned int> m_Remaining;
+};
+
+template <class PositionOf>
+void PolygonTriangulator::Triangulate(const ObjCorner* polygon, size_t count, PositionOf&& positionOf, ObjCorner* triangles) {
+    // Newell's method: robust for slightly non-planar polygons and for collinear leading corners.
+    glm::vec3 normal(0.0f);
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 cur = positionOf(polygon[i]);
+        const glm::vec3 next = positionOf(polygon[(i + 1) % count]);
+        normal.x += (cur.y - next.y) * (cur.z + next.z);
+        normal.y += (cur.z - next.z) * (cur.x + next.x);
+        normal.z += (cur.x - next.x) * (cur.y + next.y);
+    }
+    // Drop the dominant axis; the remaining two are taken in cyclic order, so the signed area is that normal component.
+    const glm::vec3 absNormal = glm::abs(normal);
+    const int axis = absNormal.x >= absNormal.y && absNormal.x >= absNormal.z ? 0 : absNormal.y >= absNormal.z ? 1 : 2;
+    const float flip = normal[axis] < 0.0f ? -1.0f : 1.0f;
+    m_Points.resize(count);
+    bool bConvex = true;
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 position = positionOf(polygon[i]);
+        m_Points[i] = {flip * position[(axis + 1) % 3], position[(axis + 2) % 3]};
+    }
+    for (size_t i = 0; i < count && bConvex; i++) {
+        bConvex = Cross(m_Points[i], m_Points[(i + 1) % count], m_Points[(i + 2) % count]) >= 0.0f;
+    }
+
+    size_t triangle = 0;
+    auto emit = [&](size_t a, size_t b, size_t c) {
+        triangles[triangle++] = polygon[a];
+        triangles[triangle++] = polygon[b];
+        triangles[triangle++] = polygon[c];
+    };
+    if (bConvex) {
+        for (size_t i = 1; i + 1 < count; i++) {
+            emit(0, i, i + 1);
+        }
+        return;
+    }
+
+    m_Remaining.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        m_Remaining[i] = static_cast<unsigned int>(i);
+    }
+    // misses counts corners tried since the last clip. A full round without an ear means the polygon is degenerate
+    // or self-intersecting; clip anyway so the face still yields count - 2 triangles.
+    size_t i = 0, misses = 0;
+    while (m_Remaining.size() > 3) {
+        const size_t size = m_Remaining.size();
+        const size_t prev = (i + size - 1) % size, next = (i + 1) % size;
+        if (misses >= size || IsEar(prev, i, next)) {
+            emit(m_Remaining[prev], m_Remaining[i], m_Remaining[next]);
+            m_Remaining.erase(m_Remaining.begin() + i);
+            i = prev < i ? prev : prev - 1;
+            misses = 0;
+        } else {
+            i = next;
+            misses++;
+        }
+    }
+    emit(m_Remaining[0], m_Remaining[1], m_Remaining[2]);
+}
+
+inline bool PolygonTriangulator::IsEar(size_t prev, size_t cur, size_t next) const {
+    const glm::vec2& a = m_Points[m_Remaining[prev]];
+    const glm::vec2& b = m_Points[m_Remaining[cur]];
+    const glm::vec2& c = m_Points[m_Remaining[next]];
+    if (Cross(a, b, c) <= 0.0f) {
+        return false;
+    }
+    for (size_t i = 0; i < m_Remaining.size(); i++) {
+        if (i == prev || i == cur || i == next) {
+            continue;
+        }
+        const glm::vec2& p = m_Points[m_Remaining[i]];
+        // Corners repeated at the same spot (holes bridged into the outline) must not block the ear.
+        if (p == a || p == b || p == c) {
+            continue;
+        }
+        if (Cross(a, b, p) >= 0.0f && Cross(b, c, p) >= 0.0f && Cross(c, a, p) >= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Open-addressing (linear probing) map from a (v, vt, vn) corner to its vertex index.
+ * Slots are stored inline, so a lookup usually touches a single cache line.
+ */
+class CornerIndexMap {
+public:
+    explicit CornerIndexMap(size_t expectedCount = 0) { Rehash(std::max<size_t>(16, expectedCount * 2)); }
+
+    /**
+     * Returns the vertex index of corner. A new corner gets nextIndex and bInserted is set.
+     */
+    unsigned int FindOrInsert(const ObjCorner& corner, unsigned int nextIndex, bool& bInserted);
+
+    size_t Size() const { return m_Size; }
+
+private:
+    struct Slot {
+        ObjCorner key;
+        unsigned int value;
+    };
+
+    static size_t Hash(const ObjCorner& corner) {
+        uint64_t hash = corner.position * 0x9E3779B97F4A7C15ull;
+        hash ^= (corner.uv + 0x7F4A7C15ull) * 0xC2B2AE3D27D4EB4Full;
+        hash ^= (corner.normal + 0x165667B1ull) * 0x165667B19E3779F9ull;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+
+    void Rehash(size_t minCapacity);
+
+    // Position is never absent in a stored corner, so it marks empty slots.
+    std::vector<Slot> m_Slots;
+    size_t m_Mask = 0;
+    size_t m_Size = 0;
+};
+
+inline unsigned int CornerIndexMap::FindOrInsert(const ObjCorner& corner, unsigned int nextIndex, bool& bInserted) {
+    // Keep the load factor under 1/2 so probe sequences stay short.
+    if (2 * (m_Size + 1) > m_Slots.size()) {
+        Rehash(m_Slots.size() * 2);
+    }
+    for (size_t slot = Hash(corner) & m_Mask;; slot = (slot + 1) & m_Mask) {
+        Slot& candidate = m_Slots[slot];
+        if (candidate.key.position == kAbsentIndex) {
+            candidate = {corner, nextIndex};
+            m_Size++;
+            bInserted = true;
+            return nextIndex;
+        }
+        if (candidate.key == corner) {
+            bInserted = false;
+            return candidate.value;
+        }
+    }
+}
+
+inline void CornerIndexMap::Rehash(size_t minCapacity) {
+    size_t capacity = 16;
+    while (capacity < minCapacity) {
+        capacity *= 2;
+    }
+    std::vector<Slot> oldSlots(capacity, Slot{{kAbsentIndex, kAbsentIndex, kAbsentIndex}, 0});
+    oldSlots.swap(m_Slots);
+    m_Mask = capacity - 1;
+    for (const Slot& slot : oldSlots) {
+        if (slot.key.position != kAbsentIndex) {
+            size_t i = Hash(slot.key) & m_Mask;
+            while (m_Slots[i].key.position != kAbsentIndex) {
+                i = (i + 1) & m_Mask;
+            }
+            m_Slots[i] = slot;
+        }
+    }
+}
+
+} // namespace GeometryOBJUtils
@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Quadric error metric decimation (Garland and Heckbert) by half-edge collapses: a vertex is merged into one of its
+ * neighbours, so surviving vertices keep all their attributes and no new vertices are made.
+ * Vertices on a seam (several vertices at one position, i.e. a UV or normal discontinuity) or on an open border are
+ * locked, which keeps seams and silhouettes of open meshes exactly where they were.
+ */
+namespace GeometrySimplifyUtils {
+
+/** Symmetric 4x4 quadric of the squared distance to a set of planes, upper triangle. */
+struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+
+    /** weight * squared distance to the plane ax + by + cz + d = 0, (a, b, c) being unit length. */
+    static Quadric FromPlane(double a, double b, double c, double d, double weight) {
+        Quadric q;
+        q.a2 = weight * a * a, q.ab = weight * a * b, q.ac = weight * a * c, q.ad = weight * a * d;
+        q.b2 = weight * b * b, q.bc = weight * b * c, q.bd = weight * b * d;
+        q.c2 = weight * c * c, q.cd = weight * c * d;
+        q.d2 = weight * d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        a2 += o.a2, ab += o.ab, ac += o.ac, ad += o.ad;
+        b2 += o.b2, bc += o.bc, bd += o.bd;
+        c2 += o.c2, cd += o.cd;
+        d2 += o.d2;
+        return *this;
+    }
+
+    double Evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+            + c2 * z * z + 2.0 * cd * z + d2;
+    }
+};
+
+/** Vertices that must not be collapsed: seams and open borders. */
+template <class Vertex>
+std::vector<bool> FindLockedVertices(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    std::vector<bool> bLocked(vertices.size(), false);
+
+    // Seams: sort vertex ids by position, equal runs longer than one are seams.
+    std::vector<unsigned int> byPosition(vertices.size());
+    for (unsigned int i = 0; i < byPosition.size(); i++) {
+        byPosition[i] = i;
+    }
+    auto positionLess = [&](unsigned int a, unsigned int b) {
+        const glm::vec3& pa = vertices[a].position;
+        const glm::vec3& pb = vertices[b].position;
+        return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    };
+    std::sort(byPosition.begin(), byPosition.end(), positionLess);
+    for (size_t i = 1; i < byPosition.size(); i++) {
+        if (!positionLess(byPosition[i - 1], byPosition[i])) {
+            bLocked[byPosition[i - 1]] = true;
+            bLocked[byPosition[i]] = true;
+        }
+    }
+
+    // Borders: undirected edges used by a single triangle.
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        for (size_t k = 0; k < 3; k++) {
+            const uint64_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();) {
+        size_t run = i + 1;
+        while (run < edges.size() && edges[run] == edges[i]) {
+            run++;
+        }
+        if (run - i == 1) {
+            bLocked[edges[i] >> 32] = true;
+            bLocked[edges[i] & 0xffffffffu] = true;
+        }
+        i = run;
+    }
+    return bLocked;
+}
+
+struct SimplifyResult {
+    std::vector<unsigned int> indices;
+    // Largest quadric error of an accepted collapse, a squared distance.
+    double maxError = 0.0;
+};
+
+/**
+ * Collapse edges in order of increasing quadric error until at most targetTriangles remain or the next collapse
+ * would exceed maxError. Collapses that would flip a triangle or make the surface non-manifold are skipped.
+ *
+ * Works in passes instead of keeping a priority queue up to date: every pass takes the cheapest collapse of every
+ * vertex, sorts them and applies them in order, locking both ends of each for the rest of the pass so the costs of
+ * the remaining candidates stay exact. A pass stops at 1.5 times the error of the collapse that would reach the
+ * target, which keeps the order close to a strict greedy one.
+ * Returns indices into the unchanged vertex array; vertices no longer referenced are left for the caller to drop.
+ */
+template <class Vertex>
+SimplifyResult Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t targetTriangles,
+    double maxError = DBL_MAX) {
+    const size_t vertexCount = vertices.size();
+    SimplifyResult result;
+    result.indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    std::vector<unsigned int>& triangles = result.indices;
+    auto positionOf = [&](unsigned int vertex) -> const glm::vec3& { return vertices[vertex].position; };
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        const glm::vec3& p = positionOf(triangles[i]);
+        const glm::vec3 normal = glm::cross(positionOf(triangles[i + 1]) - p, positionOf(triangles[i + 2]) - p);
+        const double length = glm::length(normal);
+        if (length > 0.0) {
+            const double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+            // Weighted by area, so large faces hold their shape better than slivers.
+            const Quadric plane = Quadric::FromPlane(a, b, c, -(a * p.x + b * p.y + c * p.z), 0.5 * length);
+            for (size_t k = 0; k < 3; k++) {
+                quadrics[triangles[i + k]] += plane;
+            }
+        }
+    }
+    const std::vector<bool> bLocked = FindLockedVertices(vertices, indices);
+
+    struct Collapse {
+        unsigned int from, to;
+        double cost;
+    };
+    std::vector<Collapse> bestCollapses(vertexCount);
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> offsets(vertexCount + 1);
+    std::vector<unsigned int> vertexTriangles;
+    std::vector<bool> bTriangleRemoved;
+    std::vector<bool> bCollapseLocked(vertexCount);
+    std::vector<unsigned int> stamps(vertexCount, 0);
+    unsigned int stamp = 0;
+    auto containsVertex = [&](unsigned int triangle, unsigned int vertex) {
+        const unsigned int* corners = &triangles[3 * triangle];
+        return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex;
+    };
+
+    while (triangles.size() / 3 > targetTriangles) {
+        const size_t triangleCount = triangles.size() / 3;
+        // Vertex to triangle adjacency of this pass, CSR.
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const unsigned int index : triangles) {
+            offsets[index + 1]++;
+        }
+        for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+        vertexTriangles.resize(triangles.size());
+        {
+            std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangles.size(); i++) {
+                vertexTriangles[cursor[triangles[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+
+        // Cheapest collapse of every free vertex.
+        for (auto& collapse : bestCollapses) {
+            collapse.cost = DBL_MAX;
+        }
+        for (size_t i = 0; i < triangles.size(); i += 3) {
+            for (size_t k = 0; k < 3; k++) {
+                for (const auto [from, to] : {std::pair(triangles[i + k], triangles[i + (k + 1) % 3]),
+                         std::pair(triangles[i + (k + 1) % 3], triangles[i + k])}) {
+                    if (bLocked[from]) {
+                        continue;
+                    }
+                    Quadric q = quadrics[from];
+                    q += quadrics[to];
+                    const double cost = q.Evaluate(positionOf(to));
+                    if (cost < bestCollapses[from].cost) {
+                        bestCollapses[from] = {from, to, cost};
+                    }
+                }
+            }
+        }
+        candidates.clear();
+        for (unsigned int vertex = 0; vertex < vertexCount; vertex++) {
+            if (bestCollapses[vertex].cost <= maxError) {
+                candidates.push_back(vertex);
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [&](unsigned int a, unsigned int b) { return bestCollapses[a].cost < bestCollapses[b].cost; });
+        // A collapse removes two triangles on a closed surface.
+        const size_t collapseGoal = std::min(candidates.size() - 1, (triangleCount - targetTriangles) / 2);
+        const double errorLimit = bestCollapses[candidates[collapseGoal]].cost * 1.5;
+
+        std::fill(bCollapseLocked.begin(), bCollapseLocked.end(), false);
+        bTriangleRemoved.assign(triangleCount, false);
+        size_t liveTriangles = triangleCount;
+        size_t collapses = 0;
+        for (const unsigned int candidate : candidates) {
+            const Collapse& collapse = bestCollapses[candidate];
+            if (liveTriangles <= targetTriangles || collapse.cost > errorLimit) {
+                break;
+            }
+            const unsigned int from = collapse.from, to = collapse.to;
+            if (bCollapseLocked[from] || bCollapseLocked[to]) {
+                continue;
+            }
+            const unsigned int* fromBegin = vertexTriangles.data() + offsets[from];
+            const unsigned int* fromEnd = vertexTriangles.data() + offsets[from + 1];
+            const unsigned int* toBegin = vertexTriangles.data() + offsets[to];
+            const unsigned int* toEnd = vertexTriangles.data() + offsets[to + 1];
+
+            // Link condition: the vertices adjacent to both ends must be exactly the far corners of the shared
+            // triangles, otherwise the collapse would glue two sheets of the surface together.
+            size_t sharedTriangles = 0;
+            for (const unsigned int* triangle = fromBegin; triangle < fromEnd; triangle++) {
+                sharedTriangles += !bTriangleRemoved[*triangle] && containsVertex(*triangle, to);
+            }
+            const unsigned int toStamp = ++stamp;
+            for (const unsigned int* triangle = toBegin; triangle < toEnd; triangle++) {
+                if (!bTriangleRemoved[*triangle]) {
+                    for (size_t k = 0; k < 3; k++) {
+                        stamps[triangles[3 * *triangle + k]] = toStamp;
+                    }
+                }
+            }
+            const unsigned int countedStamp = ++stamp;
+            size_t commonNeighbours = 0;
+            for (const unsigned int* triangle = fromBegin; triangle < fromEnd; triangle++) {
+                if (bTriangleRemoved[*triangle]) {
+                    continue;
+                }
+                for (size_t k = 0; k < 3; k++) {
+                    const unsigned int neighbour = triangles[3 * *triangle + k];
+                    if (neighbour != from && neighbour != to && stamps[neighbour] == toStamp) {
+                        stamps[neighbour] = countedStamp;
+                        commonNeighbours++;
+                    }
+                }
+            }
+            if (sharedTriangles == 0 || commonNeighbours != sharedTriangles) {
+                continue;
+            }
+
+            // Moving from onto to must not flip any triangle that survives the collapse.
+            bool bFlips = false;
+            for (const unsigned int* triangle = fromBegin; triangle < fromEnd && !bFlips; triangle++) {
+                if (bTriangleRemoved[*triangle] || containsVertex(*triangle, to)) {
+                    continue;
+                }
+                const unsigned int* corners = &triangles[3 * *triangle];
+                glm::vec3 p[3], q[3];
+                for (size_t k = 0; k < 3; k++) {
+                    p[k] = positionOf(corners[k]);
+                    q[k] = corners[k] == from ? positionOf(to) : p[k];
+                }
+                const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                const glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                bFlips = glm::dot(before, after) <= 0.0f;
+            }
+            if (bFlips) {
+                continue;
+            }
+
+            for (const unsigned int* triangle = fromBegin; triangle < fromEnd; triangle++) {
+                if (bTriangleRemoved[*triangle]) {
+                    continue;
+                }
+                if (containsVertex(*triangle, to)) {
+                    bTriangleRemoved[*triangle] = true;
+                    liveTriangles--;
+                    continue;
+                }
+                for (size_t k = 0; k < 3; k++) {
+                    if (triangles[3 * *triangle + k] == from) {
+                        triangles[3 * *triangle + k] = to;
+                    }
+                }
+            }
+            quadrics[to] += quadrics[from];
+            // Both ends changed, their other candidates are stale until the next pass.
+            bCollapseLocked[from] = true;
+            bCollapseLocked[to] = true;
+            result.maxError = std::max(result.maxError, collapse.cost);
+            collapses++;
+        }
+
+        size_t kept = 0;
+        for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+            if (!bTriangleRemoved[triangle]) {
+                std::copy_n(triangles.begin() + 3 * triangle, 3, triangles.begin() + 3 * kept++);
+            }
+        }
+        triangles.resize(3 * kept);
+        if (collapses == 0) {
+            break;
+        }
+    }
+    return result;
+}
+} // namespace GeometrySimplifyUtils
@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Geometry.h"
+#include "GeometryNormals.h"
+#include "ThreadPool.h"
+
+/** One attribute stream of a GeometrySoA, ready for upload as its own vertex buffer. */
+struct GeometryStream {
+    const float* data = nullptr;
+    size_t bytes = 0;
+    // Floats per vertex.
+    unsigned int components = 0;
+    // Location of the attribute in kVertexAttributes<Vertex>, so shaders see the same inputs as with the interleaved buffer.
+    unsigned int attribute = 0;
+};
+
+/**
+ * Structure-of-arrays counterpart of Geometry: one array per vertex attribute of Vertex (positions, and normals, UVs and
+ * colors if Vertex has them) instead of an array of Vertex. Passes over one attribute read only that attribute's
+ * memory instead of striding over whole vertices, and positions can be processed several floats at a time.
+ * Converts to and from Geometry; Mesh uploads the streams as separate vertex buffers (see GetStreams).
+ */
+template <class Vertex>
+class GeometrySoA {
+public:
+    static constexpr bool kHasNormals = requires(Vertex vertex) { vertex.normal; };
+    static constexpr bool kHasTexUVs = requires(Vertex vertex) { vertex.texUV; };
+    static constexpr bool kHasColors = requires(Vertex vertex) { vertex.color; };
+
+    GeometrySoA() = default;
+    explicit GeometrySoA(const Geometry<Vertex>& geometry);
+
+    Geometry<Vertex> ToGeometry() const;
+
+    /** Same results as Geometry::GenerateNormals, see GeometryNormalsUtils::GenerateNormals. */
+    void GenerateNormals(
+        bool bFlatShading = false, ENormalWeighting weighting = ENormalWeighting::AREA, ThreadPool& pool = ThreadPool::GetGlobal());
+    BoundingBox GetBoundingBox() const;
+    /** Transform positions by matrix and normals by its inverse transpose, renormalized. */
+    void Transform(const glm::mat4& matrix);
+
+    /** The streams in attribute order, pointing into this geometry. */
+    std::vector<GeometryStream> GetStreams() const;
+
+    std::vector<glm::vec3>& GetPositions() { return m_Positions; }
+    std::vector<glm::vec3>& GetNormals() { return m_Normals; }
+    std::vector<glm::vec2>& GetTexUVs() { return m_TexUVs; }
+    std::vector<glm::vec4>& GetColors() { return m_Colors; }
+    std::vector<unsigned int>& GetIndices() { return m_Indices; }
+    const std::vector<glm::vec3>& GetPositions() const { return m_Positions; }
+    const std::vector<glm::vec3>& GetNormals() const { return m_Normals; }
+    const std::vector<glm::vec2>& GetTexUVs() const { return m_TexUVs; }
+    const std::vector<glm::vec4>& GetColors() const { return m_Colors; }
+    const std::vector<unsigned int>& GetIndices() const { return m_Indices; }
+    size_t GetNumVertices() const { return m_Positions.size(); }
+    size_t GetNumIndices() const { return m_Indices.size(); }
+    bool Empty() const { return GetNumVertices() == 0 && GetNumIndices() == 0; }
+
+private:
+    // Streams of attributes Vertex lacks stay empty.
+    std::vector<glm::vec3> m_Positions;
+    std::vector<glm::vec3> m_Normals;
+    std::vector<glm::vec2> m_TexUVs;
+    std::vector<glm::vec4> m_Colors;
+    std::vector<unsigned int> m_Indices;
+};
+
+template <class Vertex>
+GeometrySoA<Vertex>::GeometrySoA(const Geometry<Vertex>& geometry)
+    : m_Indices(geometry.GetIndices()) {
+    const std::vector<Vertex>& vertices = geometry.GetVertices();
+    m_Positions.resize(vertices.size());
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+        m_Positions[vertex] = vertices[vertex].position;
+    }
+    if constexpr (kHasNormals) {
+        m_Normals.resize(vertices.size());
+        for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+            m_Normals[vertex] = vertices[vertex].normal;
+        }
+    }
+    if constexpr (kHasTexUVs) {
+        m_TexUVs.resize(vertices.size());
+        for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+            m_TexUVs[vertex] = vertices[vertex].texUV;
+        }
+    }
+    if constexpr (kHasColors) {
+        m_Colors.resize(vertices.size());
+        for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+            m_Colors[vertex] = vertices[vertex].color;
+        }
+    }
+}
+
+template <class Vertex>
+Geometry<Vertex> GeometrySoA<Vertex>::ToGeometry() const {
+    std::vector<Vertex> vertices(m_Positions.size());
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++) {
+        vertices[vertex].position = m_Positions[vertex];
+        if constexpr (kHasNormals) {
+            vertices[vertex].normal = m_Normals[vertex];
+        }
+        if constexpr (kHasTexUVs) {
+            vertices[vertex].texUV = m_TexUVs[vertex];
+        }
+        if constexpr (kHasColors) {
+            vertices[vertex].color = m_Colors[vertex];
+        }
+    }
+    return Geometry<Vertex>(vertices, m_Indices);
+}
+
+template <class Vertex>
+void GeometrySoA<Vertex>::GenerateNormals(bool bFlatShading, ENormalWeighting weighting, ThreadPool& pool) {
+    static_assert(kHasNormals, "Vertex has no normal");
+    if (Empty()) {
+        return;
+    }
+    GeometryNormalsUtils::GenerateNormals(m_Positions.data(), m_Positions.size(), m_Indices.data(), m_Indices.size(), bFlatShading,
+        weighting, pool, [this](size_t vertex) -> glm::vec3& { return m_Normals[vertex]; });
+}
+
+template <class Vertex>
+BoundingBox GeometrySoA<Vertex>::GetBoundingBox() const {
+    BoundingBox box;
+    size_t vertex = 0;
+#ifdef GEOMETRY_NORMALS_SSE
+    // Four packed positions are three registers, xyzx yzxy zxyz; the running bounds keep that lane pattern.
+    if (m_Positions.size() >= 4) {
+        const float* floats = &m_Positions.front().x;
+        __m128 lowA = _mm_loadu_ps(floats), lowB = _mm_loadu_ps(floats + 4), lowC = _mm_loadu_ps(floats + 8);
+        __m128 highA = lowA, highB = lowB, highC = lowC;
+        for (vertex = 4; vertex + 4 <= m_Positions.size(); vertex += 4) {
+            const float* block = floats + 3 * vertex;
+            const __m128 a = _mm_loadu_ps(block), b = _mm_loadu_ps(block + 4), c = _mm_loadu_ps(block + 8);
+            lowA = _mm_min_ps(lowA, a);
+            lowB = _mm_min_ps(lowB, b);
+            lowC = _mm_min_ps(lowC, c);
+            highA = _mm_max_ps(highA, a);
+            highB = _mm_max_ps(highB, b);
+            highC = _mm_max_ps(highC, c);
+        }
+        float low[12], high[12];
+        _mm_storeu_ps(low, lowA);
+        _mm_storeu_ps(low + 4, lowB);
+        _mm_storeu_ps(low + 8, lowC);
+        _mm_storeu_ps(high, highA);
+        _mm_storeu_ps(high + 4, highB);
+        _mm_storeu_ps(high + 8, highC);
+        for (size_t i = 0; i < 12; i++) {
+            box.low[i % 3] = std::min(box.low[i % 3], low[i]);
+            box.high[i % 3] = std::max(box.high[i % 3], high[i]);
+        }
+    }
+#endif
+    glm::vec3 low = box.low, high = box.high;
+    for (; vertex < m_Positions.size(); vertex++) {
+        low = glm::min(low, m_Positions[vertex]);
+        high = glm::max(high, m_Positions[vertex]);
+    }
+    return {low, high};
+}
+
+template <class Vertex>
+void GeometrySoA<Vertex>::Transform(const glm::mat4& matrix) {
+    const glm::mat3 linear(matrix);
+    const glm::vec3 translation(matrix[3]);
+    for (glm::vec3& position : m_Positions) {
+        position = linear * position + translation;
+    }
+    if constexpr (kHasNormals) {
+        const glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+        for (glm::vec3& normal : m_Normals) {
+            const glm::vec3 transformed = normalMatrix * normal;
+            normal = glm::dot(transformed, transformed) > 0.0f ? glm::normalize(transformed) : glm::vec3(0.0f);
+        }
+    }
+}
+
+template <class Vertex>
+std::vector<GeometryStream> GeometrySoA<Vertex>::GetStreams() const {
+    auto streamOf = [](const auto& values, unsigned int components, size_t offset) {
+        using Value = typename std::decay_t<decltype(values)>::value_type;
+        GeometryStream stream{reinterpret_cast<const float*>(values.data()), values.size() * sizeof(Value), components};
+        while (kVertexAttributes<Vertex>[stream.attribute].offset != offset) {
+            stream.attribute++;
+        }
+        return stream;
+    };
+    std::vector<GeometryStream> result;
+    result.push_back(streamOf(m_Positions, 3, offsetof(Vertex, position)));
+    if constexpr (kHasNormals) {
+        result.push_back(streamOf(m_Normals, 3, offsetof(Vertex, normal)));
+    }
+    if constexpr (kHasTexUVs) {
+        result.push_back(streamOf(m_TexUVs, 2, offsetof(Vertex, texUV)));
+    }
+    if constexpr (kHasColors) {
+        result.push_back(streamOf(m_Colors, 4, offsetof(Vertex, color)));
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.attribute < b.attribute; });
+    return result;
+}
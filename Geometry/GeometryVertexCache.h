@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Index reordering for the post-transform vertex cache, after Sander, Nehab and Barczak, "Fast Triangle Reordering
+ * for Vertex Locality and Reduced Overdraw" (Tipsify), plus a FIFO cache simulator to measure the result offline.
+ */
+namespace GeometryVertexCacheUtils {
+// Entries of the simulated and targeted post-transform cache; a conservative size for current GPUs.
+static constexpr unsigned int kDefaultCacheSize = 16;
+
+struct VertexCacheStats {
+    // Average cache miss ratio: transformed vertices per triangle, 0.5 at best for large regular meshes, 3 at worst.
+    float acmr = 0.0f;
+    // Average transform to vertex ratio: transformed vertices per referenced vertex, 1 at best.
+    float atvr = 0.0f;
+};
+
+/** Simulate a FIFO post-transform cache of cacheSize entries over a triangle list. */
+inline VertexCacheStats SimulateVertexCache(
+    const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = kDefaultCacheSize) {
+    // A vertex is cached while fewer than cacheSize misses happened since it was last loaded.
+    std::vector<size_t> loadedAt(vertexCount, SIZE_MAX);
+    std::vector<bool> bReferenced(vertexCount, false);
+    size_t misses = 0;
+    size_t referenced = 0;
+    for (const unsigned int index : indices) {
+        if (loadedAt[index] == SIZE_MAX || misses - loadedAt[index] >= cacheSize) {
+            loadedAt[index] = misses++;
+        }
+        if (!bReferenced[index]) {
+            bReferenced[index] = true;
+            referenced++;
+        }
+    }
+    VertexCacheStats stats;
+    stats.acmr = indices.empty() ? 0.0f : static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = referenced == 0 ? 0.0f : static_cast<float>(misses) / referenced;
+    return stats;
+}
+
+/**
+ * Tipsify: fan out from one vertex at a time, picking the next fanning vertex among the ones just emitted that will
+ * still be in the cache after its remaining triangles are drawn. Runs in time linear in the index count.
+ * @param deadEnds if set, receives the triangle positions in the result where no cached candidate was left and the
+ * walk jumped elsewhere; they are the natural cluster boundaries for ReduceOverdraw.
+ */
+inline std::vector<unsigned int> TipsifyOrder(const std::vector<unsigned int>& indices, size_t vertexCount,
+    unsigned int cacheSize = kDefaultCacheSize, std::vector<size_t>* deadEnds = nullptr) {
+    const size_t triangleCount = indices.size() / 3;
+    // Vertex to triangle adjacency, CSR.
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (const unsigned int index : indices) {
+        offsets[index + 1]++;
+    }
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<unsigned int> triangles(indices.size());
+    {
+        std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+            triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        liveTriangles[vertex] = offsets[vertex + 1] - offsets[vertex];
+    }
+    // Time stamps of the last cache load; a vertex is cached while time - loadedAt < cacheSize.
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    std::vector<bool> bEmitted(triangleCount, false);
+    std::vector<unsigned int> deadEndStack;
+    std::vector<unsigned int> candidates;
+    size_t scanCursor = 0;
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEndStack.empty()) {
+            const unsigned int vertex = deadEndStack.back();
+            deadEndStack.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; scanCursor < vertexCount; scanCursor++) {
+            if (liveTriangles[scanCursor] > 0) {
+                return static_cast<int64_t>(scanCursor);
+            }
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    while (fanning >= 0) {
+        candidates.clear();
+        for (unsigned int i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            const unsigned int triangle = triangles[i];
+            if (bEmitted[triangle]) {
+                continue;
+            }
+            bEmitted[triangle] = true;
+            for (unsigned int corner = 3 * triangle; corner < 3 * triangle + 3; corner++) {
+                const unsigned int vertex = indices[corner];
+                result.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (time - loadedAt[vertex] > cacheSize) {
+                    loadedAt[vertex] = time++;
+                }
+            }
+        }
+
+        // Prefer the candidate loaded longest ago that stays cached while its remaining triangles are emitted.
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (const unsigned int vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - loadedAt[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                priority = static_cast<int64_t>(time - loadedAt[vertex]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+        if (next < 0) {
+            next = skipDeadEnd();
+            if (deadEnds && next >= 0) {
+                deadEnds->push_back(result.size() / 3);
+            }
+        }
+        fanning = next;
+    }
+    return result;
+}
+
+/**
+ * Tipsify's overdraw pass: split the cache-ordered triangles into clusters at dead ends where the cluster so far
+ * has an ACMR of at most lambda, then draw the clusters facing away from the mesh centroid first, since on
+ * convex-ish meshes they are the ones that occlude the rest. Cache locality is only lost at cluster boundaries.
+ */
+template <class Vertex>
+std::vector<unsigned int> ReduceOverdraw(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+    const std::vector<size_t>& deadEnds, unsigned int cacheSize = kDefaultCacheSize, float lambda = 0.75f) {
+    const size_t triangleCount = indices.size() / 3;
+    auto faceNormal = [&](size_t triangle) {
+        const glm::vec3& positionA = vertices[indices[3 * triangle]].position;
+        return glm::cross(
+            vertices[indices[3 * triangle + 1]].position - positionA, vertices[indices[3 * triangle + 2]].position - positionA);
+    };
+    auto faceCentroid = [&](size_t triangle) {
+        return (vertices[indices[3 * triangle]].position + vertices[indices[3 * triangle + 1]].position
+                   + vertices[indices[3 * triangle + 2]].position)
+            / 3.0f;
+    };
+
+    // Cluster starts, in triangles. Misses are counted as if the cache were flushed at every cluster start.
+    std::vector<size_t> clusterStarts{0};
+    {
+        std::vector<size_t> loadedAt(vertices.size(), SIZE_MAX);
+        size_t misses = 0;
+        size_t clusterMisses = 0;
+        size_t nextDeadEnd = 0;
+        for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+            for (; nextDeadEnd < deadEnds.size() && deadEnds[nextDeadEnd] < triangle; nextDeadEnd++) {
+            }
+            if (nextDeadEnd < deadEnds.size() && deadEnds[nextDeadEnd] == triangle && triangle > clusterStarts.back()
+                && clusterMisses <= lambda * (triangle - clusterStarts.back())) {
+                clusterStarts.push_back(triangle);
+                clusterMisses = 0;
+                misses += cacheSize;
+            }
+            for (size_t corner = 3 * triangle; corner < 3 * triangle + 3; corner++) {
+                const unsigned int index = indices[corner];
+                if (loadedAt[index] == SIZE_MAX || misses - loadedAt[index] >= cacheSize) {
+                    loadedAt[index] = misses++;
+                    clusterMisses++;
+                }
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+    const size_t clusterCount = clusterStarts.size() - 1;
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<float> clusterKeys(clusterCount);
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+    for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+        float clusterArea = 0.0f;
+        for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++) {
+            const glm::vec3 normal = faceNormal(triangle);
+            const float area = glm::length(normal);
+            clusterNormals[cluster] += normal;
+            clusterCentroids[cluster] += faceCentroid(triangle) * area;
+            clusterArea += area;
+        }
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterArea;
+        clusterCentroids[cluster] = clusterArea > 0.0f ? clusterCentroids[cluster] / clusterArea : faceCentroid(clusterStarts[cluster]);
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+    for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+        const glm::vec3& normal = clusterNormals[cluster];
+        clusterKeys[cluster] =
+            glm::dot(normal, normal) > 0.0f ? glm::dot(clusterCentroids[cluster] - meshCentroid, glm::normalize(normal)) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return clusterKeys[a] > clusterKeys[b]; });
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const size_t cluster : order) {
+        result.insert(result.end(), indices.begin() + 3 * clusterStarts[cluster], indices.begin() + 3 * clusterStarts[cluster + 1]);
+    }
+    return result;
+}
+
+/**
+ * New vertex numbering in order of first use by indices, so vertex fetches walk memory forward.
+ * Vertices no triangle uses keep their relative order after the used ones. Returns remap[oldIndex] = newIndex.
+ */
+inline std::vector<unsigned int> FetchOrderRemap(const std::vector<unsigned int>& indices, size_t vertexCount) {
+    constexpr unsigned int unassigned = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unassigned);
+    unsigned int next = 0;
+    for (const unsigned int index : indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = next++;
+        }
+    }
+    for (unsigned int& newIndex : remap) {
+        if (newIndex == unassigned) {
+            newIndex = next++;
+        }
+    }
+    return remap;
+}
+} // namespace GeometryVertexCacheUtils
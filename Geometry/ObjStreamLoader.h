@@ -0,0 +1,260 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "GeometryOBJ.h"
+#include "IndexBuffer.h"
+#include "MemoryUsage.h"
+#include "VertexBuffer.h"
+
+struct ObjStreamStats {
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    // Host bytes owned by the loader at its peak: attribute arrays, read block and upload staging.
+    size_t peakHostBytes = 0;
+    // Largest process resident set sampled after every block, 0 where it cannot be queried.
+    size_t peakResidentBytes = 0;
+};
+
+/**
+ * Loads an OBJ straight into a VertexBuffer/IndexBuffer without building a Geometry.
+ *
+ * The file is read in blocks of whole lines, never mapped or loaded whole. A first pass counts records so both
+ * buffers are allocated once at their final size; a second pass parses and appends triangle indices with
+ * glBufferSubData every block; vertices are then assembled and uploaded a block at a time.
+ * Only the positions and normals stay resident (faces may index any earlier record); the interleaved vertex
+ * array and the index array never exist on the host as a whole.
+ *
+ * Produces the same buffers as Geometry::LoadObj with EObjVertexMode::SHARED_POSITIONS.
+ */
+template <class Vertex>
+class ObjStreamLoader {
+public:
+    static constexpr size_t kDefaultBlockBytes = 16 << 20;
+
+    explicit ObjStreamLoader(size_t blockBytes = kDefaultBlockBytes)
+        : m_BlockBytes(std::max<size_t>(blockBytes, 4096)) {
+    }
+
+    /** Reallocates both buffers and fills them from file. Returns false if the file cannot be read. */
+    bool Load(const std::string& file, VertexBuffer<Vertex>& vertexBuffer, IndexBuffer& indexBuffer);
+
+    const ObjStreamStats& GetStats() const { return m_Stats; }
+
+private:
+    /** Calls handler(begin, end) on consecutive ranges of whole lines of file, each at most one block long. */
+    template <class Handler>
+    bool ForEachBlock(const std::string& file, Handler&& handler);
+
+    void ParseBlock(const char* begin, const char* end, IndexBuffer& indexBuffer);
+    void FlushIndices(IndexBuffer& indexBuffer);
+    void UploadVertices(VertexBuffer<Vertex>& vertexBuffer);
+    void SampleMemory();
+
+    size_t m_BlockBytes;
+    std::vector<char> m_Block;
+
+    GeometryOBJUtils::ObjRecordCounts m_Cursor;
+    std::vector<glm::vec3> m_Positions;
+    std::vector<glm::vec3> m_Normals;
+    // Normal of the last corner referencing each position, the one Geometry::LoadObj keeps.
+    std::vector<unsigned int> m_NormalLinks;
+
+    std::vector<GeometryOBJUtils::ObjCorner> m_Face;
+    GeometryOBJUtils::ObjFaceList m_Faces;
+    GeometryOBJUtils::PolygonTriangulator m_Triangulator;
+    std::vector<unsigned int> m_IndexStaging;
+    unsigned int m_UploadedIndices = 0;
+
+    ObjStreamStats m_Stats;
+};
+
+template <class Vertex>
+bool ObjStreamLoader<Vertex>::Load(const std::string& file, VertexBuffer<Vertex>& vertexBuffer, IndexBuffer& indexBuffer) {
+    using namespace GeometryOBJUtils;
+    m_Stats = {};
+    m_Block.resize(m_BlockBytes);
+
+    // Pass 1: sizes of the attribute arrays and of the index buffer.
+    ObjRecordCounts counts;
+    size_t triangleCorners = 0;
+    const bool bRead = ForEachBlock(file, [&](const char* begin, const char* end) {
+        for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+            switch (ClassifyRecord(p, end)) {
+                case EObjRecord::POSITION: counts.positions++;
+                    break;
+                case EObjRecord::NORMAL: counts.normals++;
+                    break;
+                case EObjRecord::FACE: triangleCorners += CountTriangleCorners(p, end);
+                    break;
+                default: break;
+            }
+        }
+    });
+    if (!bRead) {
+        return false;
+    }
+
+    m_Cursor = {};
+    m_Positions.assign(counts.positions, glm::vec3(0.0f));
+    m_Normals.assign(counts.normals, glm::vec3(0.0f));
+    m_NormalLinks.assign(counts.positions, kAbsentIndex);
+    m_IndexStaging.reserve(m_BlockBytes / sizeof(unsigned int));
+    m_UploadedIndices = 0;
+    vertexBuffer.Allocate(counts.positions);
+    indexBuffer.Allocate(static_cast<unsigned int>(triangleCorners));
+
+    // Pass 2: attributes into the resident arrays, triangles straight to the index buffer.
+    ForEachBlock(file, [&](const char* begin, const char* end) { ParseBlock(begin, end, indexBuffer); });
+    FlushIndices(indexBuffer);
+
+    UploadVertices(vertexBuffer);
+    m_Stats.vertexCount = counts.positions;
+    m_Stats.indexCount = m_UploadedIndices;
+
+    // Release everything; the loader may be kept around.
+    m_Positions = {};
+    m_Normals = {};
+    m_NormalLinks = {};
+    m_Faces = {};
+    m_IndexStaging = {};
+    return true;
+}
+
+template <class Vertex>
+template <class Handler>
+bool ObjStreamLoader<Vertex>::ForEachBlock(const std::string& file, Handler&& handler) {
+    std::ifstream in(file, std::ifstream::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    // Bytes of an unfinished line carried over from the previous read.
+    size_t carried = 0;
+    while (true) {
+        in.read(m_Block.data() + carried, static_cast<std::streamsize>(m_Block.size() - carried));
+        const size_t filled = carried + static_cast<size_t>(in.gcount());
+        if (filled == 0) {
+            break;
+        }
+        const char* begin = m_Block.data();
+        const char* end = begin + filled;
+        if (!in) {
+            handler(begin, end);
+            break;
+        }
+        const char* lastLineEnd = end;
+        while (lastLineEnd > begin && lastLineEnd[-1] != '\n') {
+            --lastLineEnd;
+        }
+        if (lastLineEnd == begin) {
+            // A single line longer than the block.
+            carried = filled;
+            m_Block.resize(m_Block.size() * 2);
+            continue;
+        }
+        handler(begin, lastLineEnd);
+        SampleMemory();
+        carried = end - lastLineEnd;
+        std::memmove(m_Block.data(), lastLineEnd, carried);
+    }
+    SampleMemory();
+    return true;
+}
+
+template <class Vertex>
+void ObjStreamLoader<Vertex>::ParseBlock(const char* begin, const char* end, IndexBuffer& indexBuffer) {
+    using namespace GeometryOBJUtils;
+    m_Faces.triangles.clear();
+    m_Faces.polygons.clear();
+    m_Faces.polygonCorners.clear();
+    for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+        switch (ClassifyRecord(p, end)) {
+            case EObjRecord::POSITION: {
+                glm::vec3& position = m_Positions[m_Cursor.positions++];
+                p = ParseFloat(p, end, position.x);
+                p = ParseFloat(p, end, position.y);
+                p = ParseFloat(p, end, position.z);
+                break;
+            }
+            case EObjRecord::NORMAL: {
+                glm::vec3& normal = m_Normals[m_Cursor.normals++];
+                p = ParseFloat(p, end, normal.x);
+                p = ParseFloat(p, end, normal.y);
+                p = ParseFloat(p, end, normal.z);
+                break;
+            }
+            case EObjRecord::UV: m_Cursor.uvs++;
+                break;
+            case EObjRecord::FACE: {
+                p = ParseFaceCorners(p, end, m_Cursor, m_Face);
+                m_Faces.AddFace(m_Face);
+                break;
+            }
+            case EObjRecord::OTHER: break;
+        }
+    }
+
+    // Faces only reference records read before them, so every position an n-gon needs is already known.
+    auto positionOf = [&](const ObjCorner& corner) { return m_Positions[corner.position]; };
+    for (const ObjPolygon& polygon : m_Faces.polygons) {
+        m_Triangulator.Triangulate(&m_Faces.polygonCorners[polygon.firstCorner], polygon.cornerCount, positionOf,
+            &m_Faces.triangles[polygon.firstTriangleCorner]);
+    }
+    for (const ObjCorner& corner : m_Faces.triangles) {
+        if (corner.normal != kAbsentIndex) {
+            m_NormalLinks[corner.position] = corner.normal;
+        }
+        m_IndexStaging.push_back(corner.position);
+        if (m_IndexStaging.size() == m_IndexStaging.capacity()) {
+            FlushIndices(indexBuffer);
+        }
+    }
+}
+
+template <class Vertex>
+void ObjStreamLoader<Vertex>::FlushIndices(IndexBuffer& indexBuffer) {
+    if (m_IndexStaging.empty()) {
+        return;
+    }
+    const auto count = static_cast<unsigned int>(m_IndexStaging.size());
+    indexBuffer.SetSubData(m_UploadedIndices, m_IndexStaging.data(), count);
+    m_UploadedIndices += count;
+    m_IndexStaging.clear();
+}
+
+template <class Vertex>
+void ObjStreamLoader<Vertex>::UploadVertices(VertexBuffer<Vertex>& vertexBuffer) {
+    // The read block is no longer needed, its budget goes to vertex staging.
+    const size_t blockVertices = std::max<size_t>(1, m_Block.size() / sizeof(Vertex));
+    m_Block = {};
+    std::vector<Vertex> staging(blockVertices);
+    for (size_t first = 0; first < m_Positions.size(); first += blockVertices) {
+        const size_t count = std::min(blockVertices, m_Positions.size() - first);
+        for (size_t i = 0; i < count; i++) {
+            Vertex vertex{};
+            vertex.position = m_Positions[first + i];
+            if constexpr (requires { vertex.normal; }) {
+                if (m_NormalLinks[first + i] != GeometryOBJUtils::kAbsentIndex) {
+                    vertex.normal = m_Normals[m_NormalLinks[first + i]];
+                }
+            }
+            staging[i] = vertex;
+        }
+        vertexBuffer.SetSubData(first, staging.data(), count);
+    }
+}
+
+template <class Vertex>
+void ObjStreamLoader<Vertex>::SampleMemory() {
+    const size_t hostBytes = m_Block.capacity() + m_Positions.capacity() * sizeof(glm::vec3)
+        + m_Normals.capacity() * sizeof(glm::vec3) + m_NormalLinks.capacity() * sizeof(unsigned int)
+        + m_IndexStaging.capacity() * sizeof(unsigned int) + m_Faces.triangles.capacity() * sizeof(GeometryOBJUtils::ObjCorner)
+        + m_Faces.polygonCorners.capacity() * sizeof(GeometryOBJUtils::ObjCorner);
+    m_Stats.peakHostBytes = std::max(m_Stats.peakHostBytes, hostBytes);
+    m_Stats.peakResidentBytes = std::max(m_Stats.peakResidentBytes, GetResidentSetBytes());
+}
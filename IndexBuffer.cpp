@@ -1,4 +1,7 @@
 #include "IndexBuffer.h"
+
+#include <algorithm>
+
 // Ctor that generates a Element Buffer Object and links it to indices
 IndexBuffer::IndexBuffer(unsigned int* indices, unsigned int count) {
     glGenBuffers(1, &m_ID);
@@ -28,6 +31,21 @@ void IndexBuffer::SetData(const std::vector<unsigned int>& indices) {
                  indices.data(), GL_DYNAMIC_DRAW);
 }
 
+void IndexBuffer::Allocate(unsigned int capacity) {
+    Bind();
+    m_Count = 0;
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * sizeof(unsigned int),
+                 nullptr, GL_DYNAMIC_DRAW);
+}
+
+void IndexBuffer::SetSubData(unsigned int first, const unsigned int* indices,
+                             unsigned int count) {
+    Bind();
+    m_Count = std::max(m_Count, first + count);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(unsigned int),
+                    count * sizeof(unsigned int), indices);
+}
+
 unsigned int IndexBuffer::GetCount() const { return m_Count; }
 
 void IndexBuffer::Bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID); }
@@ -19,6 +19,12 @@ class IndexBuffer {
   IndexBuffer();
 
   void SetData(const std::vector<unsigned int>& indices);
+  // Allocate storage for capacity indices; GetCount() stays 0 until SetSubData
+  // fills them
+  void Allocate(unsigned int capacity);
+  // Overwrite count indices starting at first inside the allocated storage
+  void SetSubData(unsigned int first, const unsigned int* indices,
+                  unsigned int count);
 
   unsigned int GetCount() const;
 
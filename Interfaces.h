@@ -3,9 +3,17 @@
 
 #include "Camera.h"
 #include "Shader.h"
+
+class RenderQueue;
+
 class Drawable {
    public:
     virtual ~Drawable() = default;
     virtual void Draw(CameraPtr camera) = 0;
     virtual void Update() = 0;
+    // Add the object's draws to queue instead of drawing now; false if it
+    // cannot be queued and has to be drawn with Draw.
+    virtual bool Submit(RenderQueue& queue, const CameraPtr& camera) {
+        return false;
+    }
 };
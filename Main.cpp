@@ -12,6 +12,9 @@
 // for debug sleep
 #include <thread>
 
+#include "AssetLoader.h"
+#include "Benchmarks/GeometryBenchmarks.h"
+#include "Benchmarks/RenderBenchmarks.h"
 #include "Camera.h"
 #include "IndexBuffer.h"
 #include "Mesh.h"
@@ -22,11 +25,13 @@
 #include "OGLRenderer.h"
 #include "Scene.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
 #include "Shape.h"
 #include "Shapes/Prism.h"
 #include "Shapes/Pyramid.h"
 #include "Shapes/Sphere.h"
 #include "Texture.h"
+#include "Utils/FrameTimeStats.h"
 #include "Utils/GLError.h"
 #include "Utils/Profile.h"
 #include "VertexArray.h"
@@ -176,41 +181,98 @@ void AddSolidColorModelBreakEncapsulation(Scene& scene, std::string file = "res/
 
     auto modelMesh = std::make_shared<MeshSolidColorWireframe<VertexNormalTexture>>(model, EDefaultShader::SOLID_COLOR);
 
-    modelMesh->GetShader()->SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+    modelMesh->SetColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
     auto modelShape = std::make_shared<Shape<VertexNormalTexture>>(modelMesh);
 
     scene.AddObject(modelShape);
 }
 
+void AddLodModel(Scene& scene, std::string file = "res/models/dennis.obj") {
+    auto model = Geometry<VertexNormal>::LoadObj(file);
+    model.GenerateNormals(false);
+
+    // Full detail while the model fills half the screen, 2% of its triangles once it is a small speck.
+    const std::vector<float> triangleRatios = {1.0f, 0.25f, 0.06f, 0.02f};
+    const std::vector<float> minScreenSizes = {0.5f, 0.2f, 0.08f, 0.0f};
+    const auto lodGeometries = model.GenerateLods(triangleRatios);
+    std::vector<ShapeLod<VertexNormal>> lods;
+    for (size_t lod = 0; lod < lodGeometries.size(); lod++) {
+        lods.push_back({std::make_shared<Mesh<VertexNormal>>(lodGeometries[lod], EDefaultShader::DEFAULT), minScreenSizes[lod]});
+    }
+
+    auto modelShape = std::make_shared<Shape<VertexNormal>>(lods.front().mesh);
+    modelShape->SetLods(std::move(lods), model.GetBoundingSphere());
+
+    scene.AddObject(modelShape);
+}
+
+void AddStreamedModel(Scene& scene, std::string file = "res/models/dennis.obj") {
+    auto modelMesh = std::make_shared<MeshVertexLit<VertexNormalColor>>(
+        std::vector<VertexNormalColor>{}, std::vector<unsigned int>{}, EDefaultShader::VERTEX_LIGHTING);
+    modelMesh->StreamObj(file);
+
+    auto modelShape = std::make_shared<Shape<VertexNormalColor>>(modelMesh);
+
+    scene.AddObject(modelShape);
+}
+
 int main() {
     constexpr int width = 800, height = 800;
     constexpr bool bLogFPS = true;
+    constexpr bool bRunBenchmarks = false;
     std::shared_ptr<OGLRenderer> renderer = std::make_shared<OGLRenderer>(width, height);
+    if (bRunBenchmarks) {
+        const bool bGeometryPassed = GeometryBenchmarks::RunObjBenchmarks();
+        const bool bRenderPassed = RenderBenchmarks::RunRenderBenchmarks();
+        return bGeometryPassed && bRenderPassed ? 0 : 1;
+    }
+    // Issue the default shaders' compiles up front, so the driver can build them in parallel while the scene is set up.
+    // LIGHTING is left out: material.shader is still commented out.
+    std::vector<std::string> defaultShaders;
+    for (EDefaultShader shaderType : {EDefaultShader::DEFAULT, EDefaultShader::COLOR, EDefaultShader::SOLID_COLOR,
+             EDefaultShader::SOLID_COLOR_WIREFRAME, EDefaultShader::VERTEX_LIGHTING}) {
+        defaultShaders.push_back(Shader::GetDefaultShaderPath(shaderType));
+    }
+    ShaderLibrary::GetGlobal().Preload(defaultShaders);
+
     CameraPtr camera = std::make_shared<Camera>(width, height, glm::vec3(0.0f, 0.0f, 5.0));
     Scene scene;
+    AssetLoader assetLoader;
 
-    auto model = Geometry<VertexNormalColor>::LoadObj("res/models/dennis.obj");
-    model.GenerateNormals(false);
-    auto meshVertLit = std::make_shared<MeshVertexLit<VertexNormalColor>>(model, EDefaultShader::VERTEX_LIGHTING);
+    // Parsed on a worker and uploaded a slice per frame; the shape shows up once its mesh is on the GPU.
+    auto meshVertLit =
+        std::make_shared<MeshVertexLit<VertexNormalColor>>(Geometry<VertexNormalColor>(), EDefaultShader::VERTEX_LIGHTING);
     meshVertLit->SetLightPosition({0.0f, 0.0f, 0.0f});
     auto shapeVertLit = std::make_shared<Shape<VertexNormalColor>>(meshVertLit);
-    scene.AddObject(shapeVertLit);
+    scene.AddObjectWhenReady(shapeVertLit, assetLoader.LoadMeshAsync<VertexNormalColor>("res/models/dennis.obj", meshVertLit,
+        [](Geometry<VertexNormalColor>& model) { model.GenerateNormals(false); }));
+
+    // Edits to res/shaders show up without a restart.
+    ShaderLibrary::GetGlobal().SetHotReload(true);
 
     double lastTime = glfwGetTime();
+    double frameStart = lastTime;
     unsigned int frames = 1;
+    FrameTimeStats frameTimes;
 
     while (!glfwWindowShouldClose(renderer->GetWindow())) {
         double currentTime = glfwGetTime();
+        frameTimes.AddFrame((currentTime - frameStart) * 1000.0);
+        frameStart = currentTime;
         if (currentTime - lastTime >= 1.0f) {
             double delta = (currentTime - lastTime) / frames;
             if (bLogFPS) {
-                std::cout << "Frame: " << delta * 1000 << "ms / << fps: " << 1 / delta << "\n";
+                std::cout << "Frame: " << delta * 1000 << "ms / << fps: " << 1 / delta << " / " << frameTimes.ToString() << "\n";
             }
             frames = 0;
+            frameTimes.Reset();
             lastTime = glfwGetTime();
         }
 
+        assetLoader.ProcessUploads();
+        ShaderLibrary::GetGlobal().Update();
+
         renderer->Clear();
 
         scene.Draw(camera);
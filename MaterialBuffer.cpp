@@ -0,0 +1,114 @@
+#include "MaterialBuffer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Shader.h"
+
+MaterialBuffer::MaterialBuffer(size_t capacity) {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    const size_t unit = std::max<size_t>(alignment, 1);
+    m_Stride = (sizeof(MaterialUniforms) + unit - 1) / unit * unit;
+    Reallocate(std::max<size_t>(capacity, 1));
+}
+
+MaterialBuffer::Handle MaterialBuffer::Allocate() {
+    if (!m_FreeHandles.empty()) {
+        const Handle handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        return handle;
+    }
+    if (m_SlotCount == m_Capacity) {
+        Reallocate(m_Capacity * 2);
+    }
+    return static_cast<Handle>(m_SlotCount++);
+}
+
+void MaterialBuffer::Free(Handle handle) {
+    m_FreeHandles.push_back(handle);
+}
+
+void MaterialBuffer::Upload(Handle handle, const MaterialUniforms& uniforms) {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, handle * m_Stride, sizeof(MaterialUniforms), &uniforms);
+    m_Stats.uploads++;
+    m_Stats.uploadedBytes += sizeof(MaterialUniforms);
+}
+
+void MaterialBuffer::Bind(Handle handle) {
+    if (m_BoundHandle == handle) {
+        m_Stats.skippedBinds++;
+        return;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(EUniformBlock::MATERIAL), m_ID, handle * m_Stride,
+        sizeof(MaterialUniforms));
+    m_BoundHandle = handle;
+    m_Stats.binds++;
+}
+
+void MaterialBuffer::Delete() const {
+    glDeleteBuffers(1, &m_ID);
+}
+
+void MaterialBuffer::Reallocate(size_t capacity) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, capacity * m_Stride, nullptr, GL_DYNAMIC_DRAW);
+    if (m_ID != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_ID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_UNIFORM_BUFFER, 0, 0, m_SlotCount * m_Stride);
+        glDeleteBuffers(1, &m_ID);
+    }
+    m_ID = buffer;
+    m_Capacity = capacity;
+    // The binding point held a range of the deleted buffer.
+    m_BoundHandle.reset();
+}
+
+MaterialBlock::MaterialBlock(MaterialBlock&& other) noexcept
+    : m_Uniforms(other.m_Uniforms),
+      m_Handle(std::exchange(other.m_Handle, std::nullopt)),
+      m_bDirty(other.m_bDirty) {
+}
+
+MaterialBlock& MaterialBlock::operator=(const MaterialBlock& other) {
+    m_Uniforms = other.m_Uniforms;
+    m_bDirty = true;
+    return *this;
+}
+
+MaterialBlock& MaterialBlock::operator=(MaterialBlock&& other) noexcept {
+    if (this != &other) {
+        Release();
+        m_Uniforms = other.m_Uniforms;
+        m_Handle = std::exchange(other.m_Handle, std::nullopt);
+        m_bDirty = other.m_bDirty;
+    }
+    return *this;
+}
+
+MaterialBlock::~MaterialBlock() {
+    Release();
+}
+
+void MaterialBlock::Bind() {
+    MaterialBuffer& buffer = MaterialBuffer::GetGlobal();
+    if (!m_Handle) {
+        m_Handle = buffer.Allocate();
+        m_bDirty = true;
+    }
+    if (m_bDirty) {
+        buffer.Upload(*m_Handle, m_Uniforms);
+        m_bDirty = false;
+    }
+    buffer.Bind(*m_Handle);
+}
+
+void MaterialBlock::Release() {
+    if (m_Handle) {
+        MaterialBuffer::GetGlobal().Free(*m_Handle);
+        m_Handle.reset();
+    }
+}
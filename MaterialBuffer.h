@@ -0,0 +1,127 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * The "Material" uniform block of the shaders (EUniformBlock::MATERIAL), in std140 layout:
+ * layout(std140) uniform Material { vec4 u_Color; vec4 u_LineColor; vec4 u_Ambient; vec4 u_Diffuse; vec4 u_Specular;
+ * float u_LineWidth; };
+ * One block serves every mesh type; a shader declares it whole and reads the members it needs.
+ */
+struct MaterialUniforms {
+    glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f};
+    glm::vec4 lineColor{0.0f, 0.0f, 0.0f, 1.0f};
+    glm::vec4 ambient{0.0f};
+    glm::vec4 diffuse{0.0f};
+    // xyz, w = shininess
+    glm::vec4 specular{0.0f};
+    float lineWidth = 1.0f;
+    float padding[3] = {};
+};
+
+/**
+ * Material blocks of all meshes in one uniform buffer, one slot each at the driver's offset alignment. A slot is
+ * uploaded when its values change; drawing with it binds its range to EUniformBlock::MATERIAL, and not even that when
+ * the previous draw used the same slot.
+ * Slots are addressed by handle, which stays valid when the buffer grows. Like the other GL wrappers the buffer does not
+ * delete its GL buffer on destruction, see Delete.
+ */
+class MaterialBuffer {
+public:
+    using Handle = uint32_t;
+
+    static constexpr size_t kDefaultCapacity = 256;
+
+    struct Stats {
+        // glBufferSubData calls, one per changed slot, and the bytes they sent.
+        size_t uploads = 0;
+        size_t uploadedBytes = 0;
+        // glBindBufferRange calls, and binds skipped because the slot was bound already.
+        size_t binds = 0;
+        size_t skippedBinds = 0;
+    };
+
+    /** Needs a current GL context. */
+    explicit MaterialBuffer(size_t capacity = kDefaultCapacity);
+
+    MaterialBuffer(const MaterialBuffer&) = delete;
+    MaterialBuffer& operator=(const MaterialBuffer&) = delete;
+
+    /** A free slot, growing the buffer if there is none. Its contents are undefined until Upload. */
+    Handle Allocate();
+    void Free(Handle handle);
+
+    void Upload(Handle handle, const MaterialUniforms& uniforms);
+    /** Make handle's slot the Material block of the following draws. */
+    void Bind(Handle handle);
+    void Delete() const;
+
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetAllocationCount() const { return m_SlotCount - m_FreeHandles.size(); }
+    /** Bytes from one slot to the next: sizeof(MaterialUniforms) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. */
+    size_t GetStride() const { return m_Stride; }
+
+    const Stats& GetStats() const { return m_Stats; }
+    void ResetStats() { m_Stats = {}; }
+
+    /** Buffer behind MaterialBlock. It lives as long as the process, like the GL context. */
+    static MaterialBuffer& GetGlobal() {
+        static MaterialBuffer buffer;
+        return buffer;
+    }
+
+private:
+    /** Replace the GL buffer with one of capacity slots and copy the current slots over. */
+    void Reallocate(size_t capacity);
+
+    GLuint m_ID = 0;
+    size_t m_Stride = 0;
+    size_t m_Capacity = 0;
+    // Slots handed out so far, live or freed.
+    size_t m_SlotCount = 0;
+    std::vector<Handle> m_FreeHandles;
+    // The slot at EUniformBlock::MATERIAL, if it was bound by this buffer.
+    std::optional<Handle> m_BoundHandle;
+    Stats m_Stats;
+};
+
+/**
+ * The material values of one mesh or shared Material, and their slot in the global MaterialBuffer. Editing marks the
+ * values dirty; Bind uploads them if they are, so a material that does not change is uploaded once. The slot is taken
+ * on the first Bind, when there is a GL context, and returned on destruction. A copy gets a slot of its own.
+ */
+class MaterialBlock {
+public:
+    MaterialBlock() = default;
+    explicit MaterialBlock(const MaterialUniforms& uniforms) : m_Uniforms(uniforms) {}
+    MaterialBlock(const MaterialBlock& other) : m_Uniforms(other.m_Uniforms) {}
+    MaterialBlock(MaterialBlock&& other) noexcept;
+    MaterialBlock& operator=(const MaterialBlock& other);
+    MaterialBlock& operator=(MaterialBlock&& other) noexcept;
+    ~MaterialBlock();
+
+    const MaterialUniforms& Get() const { return m_Uniforms; }
+    /** The values for writing; they are uploaded on the next Bind. */
+    MaterialUniforms& Edit() {
+        m_bDirty = true;
+        return m_Uniforms;
+    }
+
+    /** Upload the values if they changed and bind the slot for the next draws. */
+    void Bind();
+
+    bool IsDirty() const { return m_bDirty; }
+    std::optional<MaterialBuffer::Handle> GetHandle() const { return m_Handle; }
+
+private:
+    void Release();
+
+    MaterialUniforms m_Uniforms;
+    std::optional<MaterialBuffer::Handle> m_Handle;
+    bool m_bDirty = true;
+};
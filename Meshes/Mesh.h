@@ -1,14 +1,20 @@
 #pragma once
 #include <functional>
+#include <optional>
 #include <utility>
 #include <vector>
 
+#include "BufferArena.h"
 #include "Camera.h"
 #include "Geometry.h"
+#include "GeometrySoA.h"
 #include "IndexBuffer.h"
 #include "Interfaces.h"
 #include "OGLRenderer.h"
+#include "ObjStreamLoader.h"
+#include "RenderQueue.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
 #include "Utils/Profile.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
@@ -18,19 +24,30 @@
 enum class EMeshType { MESH, MESH_SOLID_COLOR, MESH_SOLID_COLOR_WIREFRAME, MESH_MATERIAL, MESH_VERTEX_LIGHTING };
 
 template <class Vertex>
-class Mesh : public Drawable {
+class Mesh : public Drawable, public RenderQueueMesh {
 public:
     Mesh(EBasicGeometry geometry, EDefaultShader shader);
     Mesh(Geometry<Vertex> geometry, EDefaultShader shader);
+    /**
+     * Upload every stream of geometry as its own vertex buffer, bound to the attribute it has in kVertexAttributes<Vertex>.
+     * The mesh keeps no host copy of the vertices, so GetGeometry() returns only the indices.
+     */
+    Mesh(const GeometrySoA<Vertex>& geometry, EDefaultShader shader);
+    /**
+     * Place the geometry in arena instead of buffers of the mesh's own; Draw uses the arena's shared vertex array and
+     * glDrawElementsBaseVertex. The range is returned to the arena when the mesh is destroyed.
+     */
+    Mesh(const Geometry<Vertex>& geometry, EDefaultShader shader, BufferArena<Vertex>& arena);
+    Mesh(const Geometry<Vertex>& geometry, ShaderPtr shader, BufferArena<Vertex>& arena);
 
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
-        const VertexBufferLayout& layout = Vertex::GenerateLayout());
+        const std::optional<VertexBufferLayout>& layout = std::nullopt);
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, EDefaultShader shaderType,
-        const VertexBufferLayout& layout = Vertex::GenerateLayout());
+        const std::optional<VertexBufferLayout>& layout = std::nullopt);
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::string& shaderPath,
-        const VertexBufferLayout& layout = Vertex::GenerateLayout());
+        const std::optional<VertexBufferLayout>& layout = std::nullopt);
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, ShaderPtr shader,
-        const VertexBufferLayout& layout = Vertex::GenerateLayout());
+        const std::optional<VertexBufferLayout>& layout = std::nullopt);
 
     void Draw(CameraPtr Camera) override;
 
@@ -40,9 +57,41 @@ public:
 
     void SetGeometry(const Geometry<Vertex>& geometry);
 
+    /**
+     * Stream an OBJ straight into the GPU buffers with ObjStreamLoader. The mesh keeps no host copy,
+     * so GetGeometry() is empty afterwards.
+     */
+    bool StreamObj(const std::string& file, size_t blockBytes = ObjStreamLoader<Vertex>::kDefaultBlockBytes);
+
+    /**
+     * Incremental upload, so AssetLoader can spread a large mesh over several frames.
+     * Draw() skips the mesh from BeginUpload until EndUpload, which keeps geometry as the host copy.
+     */
+    void BeginUpload(size_t vertexCount, size_t indexCount);
+    void UploadVertices(size_t firstVertex, const Vertex* vertices, size_t count);
+    void UploadIndices(size_t firstIndex, const unsigned int* indices, size_t count);
+    void EndUpload(Geometry<Vertex>&& geometry);
+    bool IsUploading() const { return m_bUploading; }
+
+    /** Arena holding the geometry, or nullptr if the mesh has its own buffers. */
+    BufferArena<Vertex>* GetArena() const { return m_ArenaAllocation ? &m_ArenaAllocation.GetArena() : nullptr; }
+
+    /**
+     * Transform from the stored positions to model space, applied before the shape's model matrix.
+     * Identity unless the vertices are quantized, see VertexQuantization.
+     */
+    void SetDecodeMatrix(const glm::mat4& decodeMatrix) { m_DecodeMatrix = decodeMatrix; }
+    const glm::mat4& GetDecodeMatrix() const { return m_DecodeMatrix; }
+
     virtual void Update() override;
 
-    virtual void ApplyUniforms();
+    virtual void ApplyUniforms() override;
+
+    Shader& GetDrawShader() const override { return *m_Shader; }
+    unsigned int GetVertexArrayID() const override;
+    void BindVertexArray() const override;
+    void DrawElements() const override;
+    void DrawInstances(size_t instanceCount) const override;
 
     static EMeshType GetMeshType();
     static EDefaultShader GetDefaultShader();
@@ -54,21 +103,98 @@ private:
 
     std::function<void()> m_UpdateMethod;
 
-    VertexArray<Vertex> m_VertexArray;
-    VertexBuffer<Vertex> m_VertexBuffer;
-    IndexBuffer m_IndexBuffer;
+    /** Switch to buffers of the mesh's own, giving back the arena range if there is one. */
+    void CreateBuffers();
+
+    // Created only for meshes that are not in an arena.
+    std::optional<VertexArray<Vertex>> m_VertexArray;
+    std::optional<VertexBuffer<Vertex>> m_VertexBuffer;
+    // One per attribute for meshes built from GeometrySoA, unused otherwise.
+    std::vector<VertexBuffer<GLfloat>> m_StreamBuffers;
+    std::optional<IndexBuffer> m_IndexBuffer;
+    BufferArenaAllocation<Vertex> m_ArenaAllocation;
+
+    glm::mat4 m_DecodeMatrix = glm::mat4(1.0f);
+
+    bool m_bUploading = false;
 
 protected:
     ShaderPtr m_Shader;
 }; // class Mesh
 
+template <class Vertex>
+void Mesh<Vertex>::CreateBuffers() {
+    m_ArenaAllocation.Reset();
+    if (m_VertexArray) {
+        return;
+    }
+    m_VertexArray.emplace();
+    // The index buffer binding is recorded in the bound VAO.
+    m_VertexArray->Bind();
+    m_VertexBuffer.emplace();
+    m_IndexBuffer.emplace();
+}
+
 template <class Vertex>
 void Mesh<Vertex>::SetGeometry(const Geometry<Vertex>& geometry) {
     m_Vertices = geometry.GetVertices();
     m_Indices = geometry.GetIndices();
-    m_VertexBuffer.SetData(m_Vertices);
-    m_IndexBuffer.SetData(m_Indices);
-    m_VertexArray.AddBuffer(m_VertexBuffer, Vertex::GenerateLayout());
+    if (m_ArenaAllocation) {
+        BufferArena<Vertex>& arena = m_ArenaAllocation.GetArena();
+        m_ArenaAllocation.Reset();
+        m_ArenaAllocation = BufferArenaAllocation<Vertex>(arena, m_Vertices, m_Indices);
+        return;
+    }
+    CreateBuffers();
+    m_VertexArray->Bind();
+    m_VertexBuffer->SetData(m_Vertices);
+    m_IndexBuffer->SetData(m_Indices);
+    m_VertexArray->AddBuffer(*m_VertexBuffer);
+}
+
+template <class Vertex>
+bool Mesh<Vertex>::StreamObj(const std::string& file, size_t blockBytes) {
+    m_Vertices = {};
+    m_Indices = {};
+    CreateBuffers();
+    // The index buffer binding is recorded in the bound VAO.
+    m_VertexArray->Bind();
+    ObjStreamLoader<Vertex> loader(blockBytes);
+    if (!loader.Load(file, *m_VertexBuffer, *m_IndexBuffer)) {
+        return false;
+    }
+    m_VertexArray->AddBuffer(*m_VertexBuffer);
+    return true;
+}
+
+template <class Vertex>
+void Mesh<Vertex>::BeginUpload(size_t vertexCount, size_t indexCount) {
+    m_bUploading = true;
+    m_Vertices = {};
+    m_Indices = {};
+    CreateBuffers();
+    m_VertexArray->Bind();
+    m_VertexBuffer->Allocate(vertexCount);
+    m_IndexBuffer->Allocate(static_cast<unsigned int>(indexCount));
+}
+
+template <class Vertex>
+void Mesh<Vertex>::UploadVertices(size_t firstVertex, const Vertex* vertices, size_t count) {
+    m_VertexBuffer->SetSubData(firstVertex, vertices, count);
+}
+
+template <class Vertex>
+void Mesh<Vertex>::UploadIndices(size_t firstIndex, const unsigned int* indices, size_t count) {
+    m_VertexArray->Bind();
+    m_IndexBuffer->SetSubData(static_cast<unsigned int>(firstIndex), indices, static_cast<unsigned int>(count));
+}
+
+template <class Vertex>
+void Mesh<Vertex>::EndUpload(Geometry<Vertex>&& geometry) {
+    m_Vertices = std::move(geometry.GetVertices());
+    m_Indices = std::move(geometry.GetIndices());
+    m_VertexArray->AddBuffer(*m_VertexBuffer);
+    m_bUploading = false;
 }
 
 template <class Vertex>
@@ -91,51 +217,123 @@ Mesh<Vertex>::Mesh(Geometry<Vertex> geometry, EDefaultShader shader)
     : Mesh(geometry.GetVertices(), geometry.GetIndices(), shader) {
 }
 
+template <class Vertex>
+Mesh<Vertex>::Mesh(const GeometrySoA<Vertex>& geometry, EDefaultShader shader)
+    : m_Indices(geometry.GetIndices()),
+      m_Shader(Shader::GetDefaultShader(shader)) {
+    CreateBuffers();
+    for (const GeometryStream& stream : geometry.GetStreams()) {
+        m_StreamBuffers.emplace_back(const_cast<GLfloat*>(stream.data), static_cast<GLsizeiptr>(stream.bytes));
+        VertexBufferLayout layout;
+        layout.Push<float>(stream.components);
+        m_VertexArray->AddBuffer(m_StreamBuffers.back(), layout, stream.attribute);
+    }
+    m_VertexArray->Bind();
+    m_IndexBuffer->SetData(m_Indices);
+}
+
+template <class Vertex>
+Mesh<Vertex>::Mesh(const Geometry<Vertex>& geometry, EDefaultShader shader, BufferArena<Vertex>& arena)
+    : Mesh(geometry, Shader::GetDefaultShader(shader), arena) {
+}
+
+template <class Vertex>
+Mesh<Vertex>::Mesh(const Geometry<Vertex>& geometry, ShaderPtr shader, BufferArena<Vertex>& arena)
+    : m_Vertices(geometry.GetVertices()),
+      m_Indices(geometry.GetIndices()),
+      m_ArenaAllocation(arena, m_Vertices, m_Indices),
+      m_Shader(std::move(shader)) {
+}
+
 template <class Vertex>
 void Mesh<Vertex>::Update() {
 }
 
 template <class Vertex>
-Mesh<Vertex>::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const VertexBufferLayout& layout)
-    : Mesh(vertices, indices, Shader::GetDefaultShader(EDefaultShader::DEFAULT)) {
+Mesh<Vertex>::Mesh(
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::optional<VertexBufferLayout>& layout)
+    : Mesh(vertices, indices, Shader::GetDefaultShader(EDefaultShader::DEFAULT), layout) {
 }
 
 template <class Vertex>
 Mesh<Vertex>::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, EDefaultShader shaderType,
-    const VertexBufferLayout& layout)
-    : Mesh(vertices, indices, Shader::GetDefaultShader(shaderType)) {
+    const std::optional<VertexBufferLayout>& layout)
+    : Mesh(vertices, indices, Shader::GetDefaultShader(shaderType), layout) {
 }
 
 template <class Vertex>
 Mesh<Vertex>::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::string& shaderPath,
-    const VertexBufferLayout& layout)
-    : Mesh<Vertex>(vertices, indices, std::make_shared<Shader>(shaderPath)) {
+    const std::optional<VertexBufferLayout>& layout)
+    : Mesh<Vertex>(vertices, indices, ShaderLibrary::GetGlobal().Get(shaderPath), layout) {
 }
 
 template <class Vertex>
 Mesh<Vertex>::Mesh(
-    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, ShaderPtr shader, const VertexBufferLayout& layout) {
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, ShaderPtr shader,
+    const std::optional<VertexBufferLayout>& layout) {
     m_Vertices = vertices;
     m_Indices = indices;
-    m_VertexArray.Bind();
+    CreateBuffers();
 
-    m_VertexBuffer = VertexBuffer<Vertex>(m_Vertices);
-    m_IndexBuffer = IndexBuffer(m_Indices);
+    m_VertexBuffer->SetData(m_Vertices);
+    m_IndexBuffer->SetData(m_Indices);
 
-    m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+    if (layout) {
+        m_VertexArray->AddBuffer(*m_VertexBuffer, *layout);
+    } else {
+        m_VertexArray->AddBuffer(*m_VertexBuffer);
+    }
     m_Shader = std::move(shader);
 }
 
 template <class Vertex>
 void Mesh<Vertex>::Draw(CameraPtr camera) {
+    if (m_bUploading) {
+        return;
+    }
     m_Shader->Bind();
-    m_VertexArray.Bind();
+    BindVertexArray();
 
     ApplyUniforms();
 
-    camera->Update(*m_Shader);
+    camera->UploadUniforms();
+
+    DrawElements();
+}
+
+template <class Vertex>
+unsigned int Mesh<Vertex>::GetVertexArrayID() const {
+    return m_ArenaAllocation ? m_ArenaAllocation.GetArena().GetVertexArrayID() : m_VertexArray->m_ID;
+}
 
-    OGLRenderer::Draw(m_VertexArray, m_IndexBuffer, *m_Shader);
+template <class Vertex>
+void Mesh<Vertex>::BindVertexArray() const {
+    if (m_ArenaAllocation) {
+        m_ArenaAllocation.GetArena().Bind();
+    } else {
+        m_VertexArray->Bind();
+    }
+}
+
+template <class Vertex>
+void Mesh<Vertex>::DrawElements() const {
+    if (m_ArenaAllocation) {
+        const BufferArenaRange& range = m_ArenaAllocation.GetRange();
+        OGLRenderer::DrawBaseVertex(range.indexCount, range.firstIndex, range.firstVertex);
+    } else {
+        // The index buffer is part of the vertex array state.
+        OGLRenderer::Draw(m_IndexBuffer->GetCount());
+    }
+}
+
+template <class Vertex>
+void Mesh<Vertex>::DrawInstances(size_t instanceCount) const {
+    if (m_ArenaAllocation) {
+        const BufferArenaRange& range = m_ArenaAllocation.GetRange();
+        OGLRenderer::DrawInstanced(range.indexCount, range.firstIndex, range.firstVertex, instanceCount);
+    } else {
+        OGLRenderer::DrawInstanced(m_IndexBuffer->GetCount(), 0, 0, instanceCount);
+    }
 }
 
 template <class Vertex>
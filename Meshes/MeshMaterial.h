@@ -1,19 +1,30 @@
 #pragma once
+#include "MaterialBuffer.h"
 #include "Mesh.h"
 
+/** A material shared by the meshes holding its MaterialPtr; they draw with one slot of the MaterialBuffer. */
 struct Material {
     glm::vec3 ambient;
     glm::vec3 diffuse;
     glm::vec3 specular;
     float shininess;
 
-    void ApplyUniforms(Shader& shader) {
-        shader.SetUniform3fv("Material.ambient", ambient);
-        shader.SetUniform3fv("Material.diffuse", diffuse);
-        shader.SetUniform3fv("Material.specular", specular);
-        shader.SetUniform1f("Material.shininess", shininess);
+    /** Bind the Material block, uploading it first if a field changed since the last upload. */
+    void ApplyUniforms() {
+        const MaterialUniforms& uploaded = m_Block.Get();
+        const glm::vec4 specularShininess(specular, shininess);
+        if (glm::vec3(uploaded.ambient) != ambient || glm::vec3(uploaded.diffuse) != diffuse ||
+            uploaded.specular != specularShininess) {
+            MaterialUniforms& uniforms = m_Block.Edit();
+            uniforms.ambient = glm::vec4(ambient, 1.0f);
+            uniforms.diffuse = glm::vec4(diffuse, 1.0f);
+            uniforms.specular = specularShininess;
+        }
+        m_Block.Bind();
     }
 
+private:
+    MaterialBlock m_Block;
 };
 
 using MaterialPtr = std::shared_ptr<Material>;
@@ -35,14 +46,16 @@ private:
 
 template <class Vertex>
 MeshMaterial<Vertex>::MeshMaterial(Mesh<Vertex>&& baseMesh, MaterialPtr material)
-    : Mesh<Vertex>(baseMesh),
+    : Mesh<Vertex>(std::move(baseMesh)),
       m_Material(material) {
 }
 
 template <class Vertex>
 void MeshMaterial<Vertex>::ApplyUniforms() {
     Mesh<Vertex>::ApplyUniforms();
-    m_Material->ApplyUniforms(*this->GetShader());
+    if (m_Material) {
+        m_Material->ApplyUniforms();
+    }
 }
 
 template <class Vertex>
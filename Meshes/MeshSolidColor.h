@@ -1,4 +1,5 @@
 #pragma once
+#include "MaterialBuffer.h"
 #include "Mesh.h"
 
 template <class Vertex>
@@ -10,15 +11,14 @@ public:
 
     void ApplyUniforms() override;
     void Update() override;
-    void SetColor(const glm::vec4& color) { m_Color = color; }
+    void SetColor(const glm::vec4& color) { m_Material.Edit().color = color; }
+    glm::vec4 GetColor() const { return m_Material.Get().color; }
 
     static EMeshType GetMeshType();
     static EDefaultShader GetDefaultShader();
 
-    glm::vec4& GetColorRef();
-
-private:
-    glm::vec4 m_Color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+protected:
+    MaterialBlock m_Material;
 };
 
 template <class Vertex>
@@ -33,8 +33,8 @@ EMeshType MeshSolidColor<Vertex>::GetMeshType() {
 
 template <class Vertex>
 MeshSolidColor<Vertex>::MeshSolidColor(Mesh<Vertex>&& baseMesh, const glm::vec4& color)
-    : Mesh<Vertex>(baseMesh) {
-    m_Color = color;
+    : Mesh<Vertex>(std::move(baseMesh)) {
+    SetColor(color);
 }
 
 template <class Vertex>
@@ -42,15 +42,10 @@ void MeshSolidColor<Vertex>::Update() {
     Mesh<Vertex>::Update();
 }
 
-template <class Vertex>
-glm::vec4& MeshSolidColor<Vertex>::GetColorRef() {
-    return m_Color;
-}
-
 template <class Vertex>
 void MeshSolidColor<Vertex>::ApplyUniforms() {
     Mesh<Vertex>::ApplyUniforms();
-    this->GetShader()->SetUniform4fv("u_Color", m_Color);
+    m_Material.Bind();
 }
 
 template <class Vertex>
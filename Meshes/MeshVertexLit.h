@@ -17,7 +17,7 @@ private:
 
 template <class Vertex>
 MeshVertexLit<Vertex>::MeshVertexLit(Mesh<Vertex>&& baseMesh, const glm::vec3& lightPos)
-    : Mesh<Vertex>(baseMesh),
+    : Mesh<Vertex>(std::move(baseMesh)),
       m_LightPos(lightPos) {
 }
 
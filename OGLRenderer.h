@@ -1,7 +1,15 @@
 #pragma once
+#include "glad/glad.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+
 #include "IndexBuffer.h"
+#include "Shader.h"
+#include "ShaderLibrary.h"
 #include "VertexArray.h"
-#include "glad/glad.h"
 
 enum class EPolygonMode { FILL, LINE, POINT };
 
@@ -22,7 +30,10 @@ public:
         : m_Width(width),
           m_Height(height) { Init(width, height); }
 
+    /** Release the GL objects that outlive main's locals while the context is still current. */
     static void Finalize() {
+        // The library is a function-local static, destroyed after glfwTerminate; its programs have to go first.
+        ShaderLibrary::GetGlobal().Clear();
     };
 
     ~OGLRenderer() {
@@ -34,6 +45,19 @@ public:
         glDrawElements(GL_TRIANGLES, indices, GL_UNSIGNED_INT, nullptr);
     }
 
+    /** Draw indexCount indices from firstIndex of the bound index buffer, each offset by baseVertex. */
+    static void DrawBaseVertex(size_t indexCount, size_t firstIndex, size_t baseVertex) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(firstIndex * sizeof(unsigned int)), static_cast<GLint>(baseVertex));
+    }
+
+    /** DrawBaseVertex for instanceCount instances; per-instance attributes advance with gl_InstanceID. */
+    static void DrawInstanced(size_t indexCount, size_t firstIndex, size_t baseVertex, size_t instanceCount) {
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(firstIndex * sizeof(unsigned int)), static_cast<GLsizei>(instanceCount),
+            static_cast<GLint>(baseVertex));
+    }
+
     template <class Vertex>
     static void Draw(const VertexArray<Vertex>& va, const IndexBuffer& ib, const Shader& shader) {
         shader.Bind();
@@ -61,6 +85,19 @@ public:
         }
     };
 
+    /** Whether the current context reports extension, e.g. "GL_KHR_parallel_shader_compile". */
+    static bool HasExtension(const char* extension) {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; i++) {
+            const GLubyte* name = glGetStringi(GL_EXTENSIONS, i);
+            if (name && std::strcmp(reinterpret_cast<const char*>(name), extension) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     static void GetWindowSize(int& outWidth, int& outHeight) {
         if (GWindow) {
             glfwGetWindowSize(GWindow, &outWidth, &outHeight);
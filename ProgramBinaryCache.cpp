@@ -0,0 +1,190 @@
+#include "ProgramBinaryCache.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include "GeometryCache.h"
+#include "OGLRenderer.h"
+
+namespace {
+// GL_ARB_get_program_binary, not part of the GL 3.3 loader.
+constexpr GLenum kProgramBinaryRetrievableHint = 0x8257;
+constexpr GLenum kProgramBinaryLength = 0x8741;
+constexpr GLenum kNumProgramBinaryFormats = 0x87FE;
+
+using GetProgramBinaryFn = void(APIENTRYP)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+using ProgramBinaryFn = void(APIENTRYP)(GLuint, GLenum, const void*, GLsizei);
+using ProgramParameteriFn = void(APIENTRYP)(GLuint, GLenum, GLint);
+
+GetProgramBinaryFn getProgramBinary = nullptr;
+ProgramBinaryFn programBinary = nullptr;
+ProgramParameteriFn programParameteri = nullptr;
+
+std::string GetString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+bool HasProgramBinaryExtension() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > 4 || (major == 4 && minor >= 1) || OGLRenderer::HasExtension("GL_ARB_get_program_binary");
+}
+
+std::string GetHashName(const std::string& value) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx",
+        static_cast<unsigned long long>(GeometryCacheUtils::HashBytes(value.data(), value.size())));
+    return name;
+}
+} // namespace
+
+bool ProgramBinaryCache::IsSupported() {
+    if (m_bSupported) {
+        return *m_bSupported;
+    }
+    m_bSupported = false;
+    if (!HasProgramBinaryExtension()) {
+        return false;
+    }
+    getProgramBinary = reinterpret_cast<GetProgramBinaryFn>(glfwGetProcAddress("glGetProgramBinary"));
+    programBinary = reinterpret_cast<ProgramBinaryFn>(glfwGetProcAddress("glProgramBinary"));
+    programParameteri = reinterpret_cast<ProgramParameteriFn>(glfwGetProcAddress("glProgramParameteri"));
+    GLint formatCount = 0;
+    glGetIntegerv(kNumProgramBinaryFormats, &formatCount);
+    m_Driver = GetString(GL_VENDOR) + '\n' + GetString(GL_RENDERER) + '\n' + GetString(GL_VERSION);
+    m_bSupported = getProgramBinary && programBinary && programParameteri && formatCount > 0;
+    return *m_bSupported;
+}
+
+std::string ProgramBinaryCache::GetCachePath(const std::string& key, const std::string& source) {
+    IsSupported();
+    const std::string name = GetHashName(key) + '_' + GetHashName(source + '\0' + m_Driver);
+    return (std::filesystem::path(m_Directory) / (name + kExtension)).string();
+}
+
+bool ProgramBinaryCache::Load(GLuint program, const std::string& key, const std::string& source) {
+    if (!IsActive()) {
+        return false;
+    }
+    std::ifstream in(GetCachePath(key, source), std::ifstream::binary);
+    A1ProgHeader header{};
+    if (!in.is_open() || !in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.sourceSize != source.size() || header.sourceHash != GeometryCacheUtils::HashBytes(source.data(), source.size())
+        || header.driverLength != m_Driver.size()) {
+        m_Stats.misses++;
+        return false;
+    }
+    std::string driver(header.driverLength, '\0');
+    std::vector<char> binary(header.binaryLength);
+    if (!in.read(driver.data(), driver.size()) || driver != m_Driver || !in.read(binary.data(), binary.size())) {
+        m_Stats.misses++;
+        return false;
+    }
+
+    programBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint bLinked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+    if (!bLinked) {
+        m_Stats.rejects++;
+        return false;
+    }
+    m_Stats.loads++;
+    return true;
+}
+
+void ProgramBinaryCache::PrepareLink(GLuint program) {
+    if (IsActive()) {
+        programParameteri(program, kProgramBinaryRetrievableHint, GL_TRUE);
+    }
+}
+
+bool ProgramBinaryCache::Save(GLuint program, const std::string& key, const std::string& source) {
+    if (!IsActive()) {
+        return false;
+    }
+    GLint bLinked = GL_FALSE, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+    glGetProgramiv(program, kProgramBinaryLength, &length);
+    if (!bLinked || length <= 0) {
+        return false;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    getProgramBinary(program, length, &length, &format, binary.data());
+
+    A1ProgHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sourceHash = GeometryCacheUtils::HashBytes(source.data(), source.size());
+    header.sourceSize = source.size();
+    header.binaryFormat = format;
+    header.driverLength = static_cast<uint32_t>(m_Driver.size());
+    header.binaryLength = static_cast<uint64_t>(length);
+
+    // Written through a temporary file, so a crash never leaves a truncated binary behind.
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+    const std::string cacheFile = GetCachePath(key, source);
+    const std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream out(tempFile, std::ofstream::binary | std::ofstream::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(m_Driver.data(), m_Driver.size());
+        out.write(binary.data(), length);
+        if (!out) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tempFile, cacheFile, error);
+    if (error) {
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+    m_Stats.saves++;
+    Evict(key, cacheFile);
+    return true;
+}
+
+void ProgramBinaryCache::Evict(const std::string& key, const std::string& keepFile) {
+    const std::string keyPrefix = GetHashName(key) + '_';
+    const std::filesystem::path keep(keepFile);
+    std::error_code error;
+    std::vector<std::filesystem::path> outdated;
+    for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error)) {
+        const std::filesystem::path& path = entry.path();
+        if (path.extension() != kExtension || path.filename() == keep.filename()) {
+            continue;
+        }
+        const std::string stem = path.stem().string();
+        // Version 1 files are named after the source hash alone and cannot be matched to a key.
+        if (stem.rfind(keyPrefix, 0) == 0 || stem.find('_') == std::string::npos) {
+            outdated.push_back(path);
+        }
+    }
+    for (const std::filesystem::path& path : outdated) {
+        if (std::filesystem::remove(path, error)) {
+            m_Stats.evictions++;
+        }
+    }
+}
+
+void ProgramBinaryCache::Clear() {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error)) {
+        if (entry.path().extension() == kExtension) {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+}
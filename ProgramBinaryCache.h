@@ -0,0 +1,97 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+/**
+ * ".a1prog" on-disk cache of linked program binaries (glGetProgramBinary, core since GL 4.1), so that a program compiled
+ * in an earlier run is loaded instead of compiled from GLSL.
+ *
+ * Layout: A1ProgHeader, driverLength bytes of driver string, binaryLength bytes of program binary.
+ * A file is named "<key hash>_<source hash>": a hash of the key naming the program (its file and defines), then one of
+ * the program's sources and of the driver's vendor, renderer and version strings. The header repeats the sources and
+ * the driver, so a file is only tried with the sources and driver it was made with. The driver may still reject the
+ * binary; Shader then compiles the sources and the file is rewritten.
+ * Saving a program removes the other files of its key, made from sources or by drivers it no longer uses, so the cache
+ * keeps one file per program.
+ * The GL 3.3 loader has no program binary entry points, so they are looked up at first use. Without them, or if the
+ * driver offers no binary format, the cache stays off and every program is compiled.
+ */
+class ProgramBinaryCache {
+public:
+    static constexpr char kMagic[4] = {'A', '1', 'P', 'G'};
+    static constexpr uint32_t kVersion = 2;
+    static constexpr auto kExtension = ".a1prog";
+    static constexpr auto kDefaultDirectory = "res/shaders/cache";
+
+    struct A1ProgHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        uint32_t binaryFormat;
+        uint32_t driverLength;
+        uint64_t binaryLength;
+    };
+
+    struct Stats {
+        // Programs linked from a cached binary.
+        size_t loads = 0;
+        // Cached binaries the driver refused to link.
+        size_t rejects = 0;
+        // Programs without a usable cache file, compiled from source.
+        size_t misses = 0;
+        size_t saves = 0;
+        // Outdated files of a program removed when its binary was saved.
+        size_t evictions = 0;
+    };
+
+    explicit ProgramBinaryCache(std::string directory = kDefaultDirectory) : m_Directory(std::move(directory)) {}
+
+    /**
+     * Link program from the binary cached for key and source, the concatenated sources of all its stages. key names the
+     * program independently of its sources, e.g. ShaderLibrary::MakeKey. On false, program is left unlinked and can be
+     * built from source as usual.
+     */
+    bool Load(GLuint program, const std::string& key, const std::string& source);
+    /** Ask the driver to keep the binary of program retrievable; call between attaching the shaders and linking. */
+    void PrepareLink(GLuint program);
+    /** Write the binary of program, linked from source, to the cache, and remove the older files of key. */
+    bool Save(GLuint program, const std::string& key, const std::string& source);
+
+    /** Whether the context supports program binaries. Needs a current GL context on first call. */
+    bool IsSupported();
+    void SetEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+    bool IsEnabled() const { return m_bEnabled; }
+
+    const std::string& GetDirectory() const { return m_Directory; }
+    std::string GetCachePath(const std::string& key, const std::string& source);
+    /** Delete all cache files in the directory. */
+    void Clear();
+
+    const Stats& GetStats() const { return m_Stats; }
+    void ResetStats() { m_Stats = {}; }
+
+    /** The cache behind every Shader. */
+    static ProgramBinaryCache& GetGlobal() {
+        static ProgramBinaryCache cache;
+        return cache;
+    }
+
+private:
+    bool IsActive() { return m_bEnabled && IsSupported(); }
+    /** Delete the files of key other than keepFile, and files named before keys were part of the name. */
+    void Evict(const std::string& key, const std::string& keepFile);
+
+    std::string m_Directory;
+    // Vendor, renderer and version, one per line.
+    std::string m_Driver;
+    // Decided on first use, when there is a context.
+    std::optional<bool> m_bSupported;
+    bool m_bEnabled = true;
+    Stats m_Stats;
+};
@@ -0,0 +1,114 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+void RenderQueue::Add(RenderQueueMesh& mesh, const glm::mat4& model) {
+    Shader& shader = mesh.GetDrawShader();
+    const unsigned int vertexArray = mesh.GetVertexArrayID();
+    m_Order.emplace_back(MakeSortKey(shader.m_ID, vertexArray, &mesh), static_cast<uint32_t>(m_Packets.size()));
+    m_Packets.push_back({&mesh, &shader, vertexArray, model});
+}
+
+uint64_t RenderQueue::MakeSortKey(unsigned int program, unsigned int vertexArray, const RenderQueueMesh* mesh) {
+    // Meshes are heap objects at least 16 bytes apart, so the low address bits say little.
+    const uint64_t meshBits = (reinterpret_cast<uintptr_t>(mesh) >> 4) & 0xffffffu;
+    return (uint64_t(program & 0xffffu) << 48) | (uint64_t(vertexArray & 0xffffffu) << 24) | meshBits;
+}
+
+void RenderQueue::Flush(Camera& camera) {
+    if (m_bSort) {
+        std::sort(m_Order.begin(), m_Order.end());
+    }
+    BuildBatches();
+
+    m_Stats = {};
+    m_Stats.cameraUpdates = camera.UploadUniforms() ? 1 : 0;
+    Shader* shader = nullptr;
+    UniformHandle modelUniform, instancedUniform;
+    unsigned int vertexArray = 0;
+    RenderQueueMesh* mesh = nullptr;
+    for (const Batch& batch : m_Batches) {
+        const DrawPacket& packet = m_Packets[m_Order[batch.begin].second];
+        if (packet.shader != shader) {
+            shader = packet.shader;
+            shader->Bind();
+            modelUniform = shader->GetUniformHandle("u_Model");
+            instancedUniform = shader->GetUniformHandle("u_Instanced");
+            m_Stats.programBinds++;
+        }
+        if (packet.vertexArray != vertexArray || m_Stats.vertexArrayBinds == 0) {
+            vertexArray = packet.vertexArray;
+            packet.mesh->BindVertexArray();
+            m_Stats.vertexArrayBinds++;
+        }
+        if (packet.mesh != mesh) {
+            mesh = packet.mesh;
+            mesh->ApplyUniforms();
+            m_Stats.materialApplies++;
+        }
+        const size_t instanceCount = batch.end - batch.begin;
+        if (instanceCount >= kMinInstances) {
+            BindInstanceMatrices(batch.firstInstance);
+            shader->SetUniform1i(instancedUniform, 1);
+            mesh->DrawInstances(instanceCount);
+            shader->SetUniform1i(instancedUniform, 0);
+            UnbindInstanceMatrices();
+            m_Stats.instancedDraws++;
+            m_Stats.instances += instanceCount;
+        } else {
+            shader->SetUniformMat4f(modelUniform, packet.model);
+            mesh->DrawElements();
+        }
+        m_Stats.drawCalls++;
+    }
+
+    m_Packets.clear();
+    m_Order.clear();
+}
+
+void RenderQueue::BuildBatches() {
+    m_Batches.clear();
+    m_InstanceMatrices.clear();
+    for (size_t begin = 0; begin < m_Order.size();) {
+        const DrawPacket& packet = m_Packets[m_Order[begin].second];
+        size_t end = begin + 1;
+        if (m_bInstancing && packet.shader->SupportsInstancing()) {
+            while (end < m_Order.size() && m_Packets[m_Order[end].second].mesh == packet.mesh) {
+                end++;
+            }
+        }
+        Batch batch{begin, end, m_InstanceMatrices.size()};
+        if (end - begin >= kMinInstances) {
+            for (size_t i = begin; i < end; i++) {
+                m_InstanceMatrices.push_back(m_Packets[m_Order[i].second].model);
+            }
+        }
+        m_Batches.push_back(batch);
+        begin = end;
+    }
+    if (m_InstanceMatrices.empty()) {
+        return;
+    }
+    if (!m_InstanceBuffer) {
+        m_InstanceBuffer.emplace();
+    }
+    m_InstanceBuffer->SetData(m_InstanceMatrices);
+}
+
+void RenderQueue::BindInstanceMatrices(size_t firstInstance) const {
+    m_InstanceBuffer->Bind();
+    for (unsigned int column = 0; column < 4; column++) {
+        const unsigned int location = kInstanceModelLocation + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            reinterpret_cast<const void*>(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void RenderQueue::UnbindInstanceMatrices() const {
+    // Left enabled, the attributes would keep reading the instance buffer in draws of this vertex array without it.
+    for (unsigned int column = 0; column < 4; column++) {
+        glDisableVertexAttribArray(kInstanceModelLocation + column);
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "Shader.h"
+#include "VertexBuffer.h"
+
+/**
+ * The steps of a mesh draw, exposed so that RenderQueue can order draws by their state and skip the steps whose state
+ * is already current. Mesh implements it for every vertex type.
+ */
+class RenderQueueMesh {
+public:
+    virtual ~RenderQueueMesh() = default;
+
+    virtual Shader& GetDrawShader() const = 0;
+    virtual unsigned int GetVertexArrayID() const = 0;
+    virtual void BindVertexArray() const = 0;
+    /** Set the per-mesh uniforms on the bound shader and bind the mesh's Material block. */
+    virtual void ApplyUniforms() = 0;
+    /** Issue the draw call; shader and vertex array are bound. */
+    virtual void DrawElements() const = 0;
+    /** Same for instanceCount instances, with the instance attributes bound. */
+    virtual void DrawInstances(size_t instanceCount) const = 0;
+};
+
+/** GL state changes made by one RenderQueue::Flush. */
+struct RenderQueueStats {
+    size_t drawCalls = 0;
+    // Draw calls that drew several packets at once, and the packets they drew.
+    size_t instancedDraws = 0;
+    size_t instances = 0;
+    size_t programBinds = 0;
+    size_t vertexArrayBinds = 0;
+    // Per-mesh uniform sets, see RenderQueueMesh::ApplyUniforms.
+    size_t materialApplies = 0;
+    // Camera uniform block uploads, at most one per frame.
+    size_t cameraUpdates = 0;
+
+    size_t GetStateChanges() const { return programBinds + vertexArrayBinds + materialApplies + cameraUpdates; }
+};
+
+/**
+ * Draw packets collected over a frame and submitted in one pass. Packets are sorted by a 64-bit key of program, vertex
+ * array and mesh, so draws sharing a program and a vertex array (e.g. meshes in one BufferArena) run back to back, and
+ * a state is only set when it differs from the previous packet's.
+ * Consecutive packets of one mesh are drawn with one instanced call if its shader supports it: their model matrices go
+ * to a per-instance attribute at kInstanceModelLocation and the shader reads it while u_Instanced is set.
+ */
+class RenderQueue {
+public:
+    /** First of the four locations of the per-instance model matrix, one column each; above any vertex attribute. */
+    static constexpr unsigned int kInstanceModelLocation = 12;
+    /** Shortest run of packets drawn instanced; a single packet is cheaper with u_Model. */
+    static constexpr size_t kMinInstances = 2;
+
+    /** Queue mesh for drawing with model as u_Model. mesh has to outlive the next Flush. */
+    void Add(RenderQueueMesh& mesh, const glm::mat4& model);
+
+    /** Draw and clear the queued packets, in key order unless sorting is off. */
+    void Flush(Camera& camera);
+
+    /** Off, packets are drawn in the order they were added; the redundant state is still skipped. */
+    void SetSorting(bool bSort) { m_bSort = bSort; }
+    bool IsSorting() const { return m_bSort; }
+    /** Off, every packet is drawn on its own with u_Model. */
+    void SetInstancing(bool bInstancing) { m_bInstancing = bInstancing; }
+    bool IsInstancing() const { return m_bInstancing; }
+
+    size_t GetPacketCount() const { return m_Packets.size(); }
+    /** Counters of the last Flush. */
+    const RenderQueueStats& GetStats() const { return m_Stats; }
+
+    /**
+     * Program in the top 16 bits, vertex array in the next 24 and the mesh address in the low 24. Names wider than their
+     * field only merge groups: the state is compared exactly when submitting, so a collision costs a redundant bind.
+     */
+    static uint64_t MakeSortKey(unsigned int program, unsigned int vertexArray, const RenderQueueMesh* mesh);
+
+private:
+    struct DrawPacket {
+        RenderQueueMesh* mesh = nullptr;
+        Shader* shader = nullptr;
+        unsigned int vertexArray = 0;
+        glm::mat4 model;
+    };
+
+    /** Packets [begin, end) of m_Order, drawn by one call. */
+    struct Batch {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t firstInstance = 0;
+    };
+
+    /** Split m_Order into batches and upload the model matrices of the instanced ones. */
+    void BuildBatches();
+    /** Point the instance attributes of the bound vertex array at the matrices from firstInstance on. */
+    void BindInstanceMatrices(size_t firstInstance) const;
+    void UnbindInstanceMatrices() const;
+
+    std::vector<DrawPacket> m_Packets;
+    // Sort key and packet index; sorting these moves 16 bytes per packet instead of a whole packet.
+    std::vector<std::pair<uint64_t, uint32_t>> m_Order;
+    std::vector<Batch> m_Batches;
+    std::vector<glm::mat4> m_InstanceMatrices;
+    // Created on first use, when there is a GL context.
+    std::optional<VertexBuffer<glm::mat4>> m_InstanceBuffer;
+    RenderQueueStats m_Stats;
+    bool m_bSort = true;
+    bool m_bInstancing = true;
+};
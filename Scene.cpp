@@ -1,12 +1,49 @@
 #include "Scene.h"
 
+#include <chrono>
+#include <exception>
+#include <iostream>
+
 #include "Profile.h"
 
 void Scene::Draw(CameraPtr camera) {
+    AddReadyObjects();
+    if (!m_bUseRenderQueue) {
+        for (const auto& DrawablePtr : m_Objects) {
+            DrawablePtr->Update();
+            DrawablePtr->Draw(camera);
+        }
+        return;
+    }
     for (const auto& DrawablePtr : m_Objects) {
         DrawablePtr->Update();
-        DrawablePtr->Draw(camera);
+        if (!DrawablePtr->Submit(m_RenderQueue, camera)) {
+            DrawablePtr->Draw(camera);
+        }
     }
+    m_RenderQueue.Flush(*camera);
 }
 
 void Scene::AddObject(DrawablePtr object) { m_Objects.push_back(object); }
+
+void Scene::AddObjectWhenReady(DrawablePtr object, std::shared_future<void> ready) {
+    m_PendingObjects.emplace_back(std::move(object), std::move(ready));
+}
+
+void Scene::AddReadyObjects() {
+    for (size_t i = 0; i < m_PendingObjects.size();) {
+        auto& [object, ready] = m_PendingObjects[i];
+        if (ready.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+        // A failed load leaves the object out instead of taking the frame down.
+        try {
+            ready.get();
+            AddObject(object);
+        } catch (const std::exception& error) {
+            std::cerr << "Scene object failed to load: " << error.what() << std::endl;
+        }
+        m_PendingObjects.erase(m_PendingObjects.begin() + i);
+    }
+}
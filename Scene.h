@@ -1,15 +1,34 @@
 #pragma once
+#include <future>
 #include <memory>
 #include <unordered_set>
 
 #include "Interfaces.h"
+#include "RenderQueue.h"
 using DrawablePtr = std::shared_ptr<Drawable>;
 
 class Scene {
 public:
     virtual void AddObject(DrawablePtr object);
+    /** Add object once ready is, e.g. when AssetLoader has uploaded its mesh. Until then it is neither updated nor drawn. */
+    virtual void AddObjectWhenReady(DrawablePtr object, std::shared_future<void> ready);
+    /**
+     * Update every object, queue the draws of those that support it (see Drawable::Submit) and submit them sorted by state.
+     * Objects that cannot be queued are drawn directly, before the queued ones.
+     */
     virtual void Draw(CameraPtr camera);
 
+    size_t GetPendingObjectCount() const { return m_PendingObjects.size(); }
+
+    /** Off, every object draws itself in insertion order, rebinding all of its state. */
+    void SetRenderQueueEnabled(bool bEnabled) { m_bUseRenderQueue = bEnabled; }
+    RenderQueue& GetRenderQueue() { return m_RenderQueue; }
+
 private:
+    void AddReadyObjects();
+
     std::vector<DrawablePtr> m_Objects;
+    std::vector<std::pair<DrawablePtr, std::shared_future<void>>> m_PendingObjects;
+    RenderQueue m_RenderQueue;
+    bool m_bUseRenderQueue = true;
 };
@@ -1,5 +1,11 @@
 #include "Shader.h"
 
+#include "OGLRenderer.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <cassert>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -39,10 +45,86 @@ ShaderProgramSource parse_shader(const std::string& filePath) {
     return {ss[0].str(), ss[1].str(), ss[2].str()};
 }
 
+// GL_KHR_parallel_shader_compile, not part of the GL 3.3 loader
+static constexpr GLenum kCompletionStatus = 0x91B1;
+using MaxShaderCompilerThreadsFn = void(APIENTRYP)(GLuint);
+
+static bool has_parallel_compile() {
+    static const bool bParallel =
+        OGLRenderer::HasExtension("GL_KHR_parallel_shader_compile");
+    return bParallel;
+}
+
+// With the extension, compile and link return before the work is done and
+// its completion can be polled; 0xFFFFFFFF lets the driver pick the threads
+static void enable_parallel_compile() {
+    static bool bEnabled = false;
+    if (bEnabled || !has_parallel_compile()) {
+        return;
+    }
+    bEnabled = true;
+    auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsFn>(
+        glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+    if (maxShaderCompilerThreads) {
+        maxShaderCompilerThreads(0xFFFFFFFF);
+    }
+}
+
+// GLSL wants #version first, so the defines go on the lines after it
+static void add_defines(std::string& source,
+    const std::vector<std::string>& defines) {
+    if (source.empty() || defines.empty()) {
+        return;
+    }
+    std::string lines;
+    for (const std::string& define : defines) {
+        lines += "#define " + define + '\n';
+    }
+    size_t insertAt = 0;
+    const size_t version = source.find("#version");
+    if (version != std::string::npos) {
+        const size_t lineEnd = source.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    }
+    source.insert(insertAt, lines);
+}
+
 // Ctor that build the Shader Program from 2 different shaders
-Shader::Shader(const std::string& filePath) {
+Shader::Shader(const std::string& filePath,
+    const std::vector<std::string>& defines)
+    : m_FilePath(filePath), m_Defines(defines) {
+    PendingLink build = BuildProgram(filePath, defines);
+    m_ID = build.program;
+    if (build.vertexShader) {
+        // Querying any status waits for the compile, so the checks wait for
+        // Finish
+        m_PendingLink = std::move(build);
+    } else {
+        ReflectUniforms();
+    }
+}
+
+Shader::PendingLink Shader::BuildProgram(const std::string& filePath,
+    const std::vector<std::string>& defines) {
     // read vertex and fragment shaders source code
     auto shaderSource = parse_shader(filePath);
+    add_defines(shaderSource.VertexSource, defines);
+    add_defines(shaderSource.FragmentSource, defines);
+    add_defines(shaderSource.GeometrySource, defines);
+
+    PendingLink build;
+    // Create Shader Program Object and get its reference
+    build.program = glCreateProgram();
+
+    // Link from the binary of an earlier run when the driver still accepts it
+    build.cacheKey = ShaderLibrary::MakeKey(filePath, defines);
+    build.programSource = shaderSource.VertexSource + '\0' +
+        shaderSource.FragmentSource + '\0' + shaderSource.GeometrySource;
+    ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetGlobal();
+    if (binaryCache.Load(build.program, build.cacheKey, build.programSource)) {
+        return build;
+    }
+
     const char* vertexSource = shaderSource.VertexSource.c_str();
     const char* fragmentSource = shaderSource.FragmentSource.c_str();
     bool useGeometryShader = !shaderSource.GeometrySource.empty();
@@ -51,52 +133,133 @@ Shader::Shader(const std::string& filePath) {
         geometrySource = shaderSource.GeometrySource.c_str();
     }
 
+    // Let the driver compile on its own threads while we go on
+    enable_parallel_compile();
+
     // Create Vertex Shader Object and get its reference
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    build.vertexShader = glCreateShader(GL_VERTEX_SHADER);
     // Attach Vertex Shader Source to the Vertex Shader Object
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glShaderSource(build.vertexShader, 1, &vertexSource, NULL);
     // Compile Vertex Shader into machine code
-    glCompileShader(vertexShader);
-    CheckForCompilationErrors(vertexShader, "Vertex");
+    glCompileShader(build.vertexShader);
 
     // Create Fragment Shader Object and get its reference
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    build.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
     // Attach Fragment Shader Source to the Vertex Shader Object
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+    glShaderSource(build.fragmentShader, 1, &fragmentSource, NULL);
     // Compile Fragment Shader into machine code
-    glCompileShader(fragmentShader);
-    CheckForCompilationErrors(fragmentShader, "Fragment");
-    GLuint geometryShader;
+    glCompileShader(build.fragmentShader);
     if (useGeometryShader) {
-        geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geometryShader, 1, &geometrySource, NULL);
-        glCompileShader(geometryShader);
-        CheckForCompilationErrors(geometryShader, "Geometry");
+        build.geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(build.geometryShader, 1, &geometrySource, NULL);
+        glCompileShader(build.geometryShader);
     }
-    // Create Shader Program Object and get its reference
-    m_ID = glCreateProgram();
-
     // Attach the Vertex and Fragment Shaders to the Shader Program
-    glAttachShader(m_ID, vertexShader);
-    glAttachShader(m_ID, fragmentShader);
+    glAttachShader(build.program, build.vertexShader);
+    glAttachShader(build.program, build.fragmentShader);
 
     if (useGeometryShader) {
-        glAttachShader(m_ID, geometryShader);
+        glAttachShader(build.program, build.geometryShader);
     }
 
     // Wrap-up/Link all the shaders together into the Shader Program
-    glLinkProgram(m_ID);
+    binaryCache.PrepareLink(build.program);
+    glLinkProgram(build.program);
+    return build;
+}
 
-    // Delete the now useless Vertex and Fragment Shader objects
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    if (useGeometryShader) {
-        glDeleteShader(geometryShader);
+bool Shader::IsLinkComplete(const PendingLink& build) {
+    if (!has_parallel_compile()) {
+        return true;
     }
+    GLint bCompleted = GL_FALSE;
+    glGetProgramiv(build.program, kCompletionStatus, &bCompleted);
+    return bCompleted;
+}
+
+bool Shader::FinishLink(const PendingLink& build) {
+    if (!build.vertexShader) {
+        // Loaded from the binary cache, which checked the link
+        return true;
+    }
+    CheckForCompilationErrors(build.vertexShader, "Vertex");
+    CheckForCompilationErrors(build.fragmentShader, "Fragment");
+    if (build.geometryShader) {
+        CheckForCompilationErrors(build.geometryShader, "Geometry");
+    }
+    const bool bLinked = CheckForLinkErrors(build.program);
+    if (bLinked) {
+        ProgramBinaryCache::GetGlobal().Save(
+            build.program, build.cacheKey, build.programSource);
+    }
+    DeleteShaders(build);
+    return bLinked;
+}
+
+// Delete the now useless Vertex and Fragment Shader objects
+void Shader::DeleteShaders(const PendingLink& build) {
+    if (!build.vertexShader) {
+        return;
+    }
+    glDeleteShader(build.vertexShader);
+    glDeleteShader(build.fragmentShader);
+    if (build.geometryShader) {
+        glDeleteShader(build.geometryShader);
+    }
+}
+
+bool Shader::IsReady() {
+    if (!m_PendingLink) {
+        return true;
+    }
+    if (!IsLinkComplete(*m_PendingLink)) {
+        return false;
+    }
+    Finish();
+    return true;
+}
+
+void Shader::Finish() const {
+    if (!m_PendingLink) {
+        return;
+    }
+    PendingLink pending = std::move(*m_PendingLink);
+    m_PendingLink.reset();
+    FinishLink(pending);
+    ReflectUniforms();
+}
+
+void Shader::Reload() {
+    if (m_PendingReload) {
+        DeleteShaders(*m_PendingReload);
+        glDeleteProgram(m_PendingReload->program);
+    }
+    m_PendingReload = BuildProgram(m_FilePath, m_Defines);
+}
+
+bool Shader::ApplyReload() {
+    if (!m_PendingReload || !IsLinkComplete(*m_PendingReload)) {
+        return false;
+    }
+    PendingLink reload = std::move(*m_PendingReload);
+    m_PendingReload.reset();
+    if (!FinishLink(reload)) {
+        std::cout << "Keeping the previous program of " << m_FilePath
+                  << std::endl;
+        glDeleteProgram(reload.program);
+        return false;
+    }
+    Finish();
+    glDeleteProgram(m_ID);
+    m_ID = reload.program;
+    // Locations belong to the old program; uniforms are set again per draw
+    ReflectUniforms();
+    return true;
 }
 
 // Activates the Shader Program
 void Shader::Bind() const {
+    Finish();
     glUseProgram(m_ID);
 }
 
@@ -106,41 +269,106 @@ void Shader::UnBind() const {
 }
 
 Shader::~Shader() {
+    if (m_PendingLink) {
+        DeleteShaders(*m_PendingLink);
+    }
+    if (m_PendingReload) {
+        DeleteShaders(*m_PendingReload);
+        glDeleteProgram(m_PendingReload->program);
+    }
     glDeleteProgram(m_ID);
 }
 
-int Shader::GetUniformLocation(const std::string& name) {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end()) {
-        return m_UniformLocationCache[name];
+UniformHandle Shader::GetUniformHandle(UniformName name) {
+    const auto [it, bInserted] = m_Uniforms.handles.try_emplace(
+        name.GetHash(), static_cast<uint32_t>(m_Uniforms.names.size()));
+    if (bInserted) {
+        m_Uniforms.names.emplace_back(name.GetName());
+        // Until the link is checked the location is resolved by Finish
+        m_Uniforms.locations.push_back(
+            m_PendingLink ? -1 : FindActiveUniform(name.GetHash()));
     }
-    auto location = glGetUniformLocation(m_ID, name.c_str());
-    m_UniformLocationCache[name] = location;
-    return location;
+    assert(m_Uniforms.names[it->second] == name.GetName());
+    return {it->second};
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2,
+GLint Shader::GetUniformLocation(UniformHandle handle) const {
+    Finish();
+    return handle.IsValid() ? m_Uniforms.locations[handle.index] : -1;
+}
+
+GLint Shader::FindActiveUniform(uint64_t hash) const {
+    const auto it = m_Uniforms.active.find(hash);
+    return it != m_Uniforms.active.end() ? it->second : -1;
+}
+
+void Shader::ReflectUniforms() const {
+    m_Uniforms.active.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_ID, i, maxLength, &length, &size, &type,
+            name.data());
+        // Members of uniform blocks have no location
+        const GLint location = glGetUniformLocation(m_ID, name.data());
+        if (location < 0) {
+            continue;
+        }
+        const std::string_view view(name.data(), length);
+        m_Uniforms.active[UniformName::Hash(view)] = location;
+        // Arrays are listed as "name[0]", but "name" is as good
+        if (view.size() > 3 && view.substr(view.size() - 3) == "[0]") {
+            m_Uniforms.active[UniformName::Hash(
+                view.substr(0, view.size() - 3))] = location;
+        }
+    }
+    for (size_t i = 0; i < m_Uniforms.names.size(); i++) {
+        m_Uniforms.locations[i] =
+            FindActiveUniform(UniformName::Hash(m_Uniforms.names[i]));
+    }
+
+    for (EUniformBlock block :
+        {EUniformBlock::CAMERA, EUniformBlock::MATERIAL}) {
+        const GLuint index =
+            glGetUniformBlockIndex(m_ID, GetUniformBlockName(block));
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(m_ID, index, static_cast<GLuint>(block));
+        }
+    }
+}
+
+void Shader::SetUniform4f(UniformHandle handle, float v0, float v1, float v2,
     float v3) {
-    glUniform4f(GetUniformLocation(name), v0, v1, v2, v3);
+    glUniform4f(GetUniformLocation(handle), v0, v1, v2, v3);
+}
+
+void Shader::SetUniform1i(UniformHandle handle, int v) {
+    glUniform1i(GetUniformLocation(handle), v);
 }
 
-void Shader::SetUniform1i(const std::string& name, int v) {
-    glUniform1i(GetUniformLocation(name), v);
+void Shader::SetUniform1f(UniformHandle handle, float v) {
+    glUniform1f(GetUniformLocation(handle), v);
 }
 
-void Shader::SetUniform1f(const std::string& name, float v) {
-    glUniform1f(GetUniformLocation(name), v);
+void Shader::SetUniformMat4f(UniformHandle handle, const glm::mat4& m) {
+    glUniformMatrix4fv(GetUniformLocation(handle), 1, false, &m[0][0]);
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& m) {
-    glUniformMatrix4fv(GetUniformLocation(name), 1, false, &m[0][0]);
+void Shader::SetUniform4fv(UniformHandle handle, const glm::vec4& vec) {
+    glUniform4fv(GetUniformLocation(handle), 1, &vec[0]);
 }
 
-void Shader::SetUniform4fv(const std::string& name, const glm::vec4& vec) {
-    glUniform4fv(GetUniformLocation(name), 1, &vec[0]);
+void Shader::SetUniform3fv(UniformHandle handle, const glm::vec3& vec) {
+    glUniform3fv(GetUniformLocation(handle), 1, &vec[0]);
 }
 
-void Shader::SetUniform3fv(const std::string& name, const glm::vec3& vec) {
-    glUniform3fv(GetUniformLocation(name), 1, &vec[0]);
+bool Shader::SupportsInstancing() {
+    return GetUniformLocation(GetUniformHandle("u_Instanced")) != -1;
 }
 
 void Shader::CheckForCompilationErrors(unsigned int shaderID,
@@ -163,6 +391,30 @@ void Shader::CheckForCompilationErrors(unsigned int shaderID,
     }
 }
 
+bool Shader::CheckForLinkErrors(unsigned int programID) {
+    int isLinked = 0;
+    glGetProgramiv(programID, GL_LINK_STATUS, &isLinked);
+    if (!isLinked) {
+        std::cout << "Shader Error!: Link" << std::endl;
+        int maxLength = 0;
+        glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &maxLength);
+        if (maxLength > 0) {
+            std::vector<char> errorLog(maxLength);
+            glGetProgramInfoLog(programID, maxLength, &maxLength, &errorLog[0]);
+            std::cout << errorLog.data() << std::endl;
+        }
+    }
+    return isLinked;
+}
+
+const char* Shader::GetUniformBlockName(EUniformBlock block) {
+    switch (block) {
+        case EUniformBlock::CAMERA: return "Camera";
+        case EUniformBlock::MATERIAL: return "Material";
+    }
+    return "";
+}
+
 std::string Shader::GetDefaultShaderPath(EDefaultShader shaderType) {
     switch (shaderType) {
         case EDefaultShader::DEFAULT: return "res/shaders/default.shader";
@@ -184,5 +436,5 @@ std::string Shader::GetDefaultShaderPath(EDefaultShader shaderType) {
 
 ShaderPtr Shader::GetDefaultShader(
     EDefaultShader shaderType = EDefaultShader::DEFAULT) {
-    return std::make_shared<Shader>(GetDefaultShaderPath(shaderType));
+    return ShaderLibrary::GetGlobal().Get(shaderType);
 }
@@ -2,12 +2,17 @@
 #include <glad/glad.h>
 
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 static struct ShaderProgramSource parse_shader(const std::string& filePath);
 
@@ -21,40 +26,190 @@ enum class EDefaultShader {
     VERTEX_LIGHTING
 };
 
+// Uniform blocks shared by all programs. Each has the binding point of its
+// value; when a program links, Shader attaches the blocks it declares there.
+enum class EUniformBlock : GLuint {
+    // view, projection and viewport, see CameraUniforms
+    CAMERA = 0,
+    // colors and line settings of the mesh drawn, see MaterialUniforms
+    MATERIAL = 1,
+};
+
 using ShaderPtr = std::shared_ptr<class Shader>;
 
-class Shader {
+// Name of a uniform with its 64-bit FNV-1a hash. For a string literal the
+// hash is computed at compile time, so setting a uniform by a literal name
+// builds no std::string and hashes nothing at run time. Only valid for the
+// call it is passed to.
+class UniformName {
+public:
+    template <size_t N>
+    consteval UniformName(const char (&name)[N])
+        : m_Name(name), m_Hash(Hash(std::string_view(name, N - 1))) {}
+    UniformName(const std::string& name)
+        : m_Name(name.c_str()), m_Hash(Hash(name)) {}
+
+    const char* GetName() const { return m_Name; }
+    uint64_t GetHash() const { return m_Hash; }
+
+    static constexpr uint64_t Hash(std::string_view name) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
 private:
-    std::unordered_map<std::string, int> m_UniformLocationCache;
+    const char* m_Name;
+    uint64_t m_Hash;
+};
+
+// Index of a uniform in one Shader's table, see Shader::GetUniformHandle.
+// Stays valid when the program is rebuilt by a hot reload.
+struct UniformHandle {
+    static constexpr uint32_t kInvalid = ~0u;
+    uint32_t index = kInvalid;
+
+    bool IsValid() const { return index != kInvalid; }
+};
 
+class Shader {
 public:
     // ID reference of the Shader Program
     GLuint m_ID;
 
-    // Ctor that build the Shader Program from 2 different shaders
-    explicit Shader(const std::string& filePath);
+    // Ctor that build the Shader Program from 2 different shaders. Each of
+    // defines ("NAME" or "NAME value") becomes a #define line after #version.
+    // Prefer ShaderLibrary, which compiles each file and defines pair once.
+    // Compile and link are only issued here; the results are checked when
+    // the program is first used, see Finish, so that the driver can build
+    // several programs at once.
+    explicit Shader(const std::string& filePath,
+        const std::vector<std::string>& defines = {});
 
     ~Shader();
 
+    // Whether the program is linked. Never blocks if the driver has
+    // GL_KHR_parallel_shader_compile; without it, waits for the link.
+    bool IsReady();
+    // Waits for compile and link, then reports their errors. Called by the
+    // first Bind or uniform access.
+    void Finish() const;
+
+    // Start building the program again from its file, e.g. after an edit.
+    // The current program stays in use until ApplyReload swaps in the new.
+    void Reload();
+    // If the rebuild has finished: swap it in when it linked, otherwise
+    // report its errors and keep the current program. Returns whether the
+    // program changed. Call between frames.
+    bool ApplyReload();
+    bool IsReloading() const { return m_PendingReload.has_value(); }
+
+    const std::string& GetFilePath() const { return m_FilePath; }
+    const std::vector<std::string>& GetDefines() const { return m_Defines; }
+
     // Activates the Shader Program
     void Bind() const;
     // Deletes the Shader Program
     void UnBind() const;
 
-    void SetUniform4f(const std::string& name, float v0, float v1, float v2,
+    // Handle of the uniform name, for sets that index an array instead of
+    // looking the name up. Inactive uniforms get a handle too, whose sets
+    // are ignored. Does not wait for the link.
+    UniformHandle GetUniformHandle(UniformName name);
+
+    void SetUniform4f(UniformHandle handle, float v0, float v1, float v2,
         float v3);
-    void SetUniform1i(const std::string& name, int v);
-    void SetUniform1f(const std::string& name, float v);
-    void SetUniformMat4f(const std::string& name, const glm::mat4& m);
-    void SetUniform4fv(const std::string& name, const glm::vec4& vec);
-    void SetUniform3fv(const std::string& name, const glm::vec3& vec);
+    void SetUniform1i(UniformHandle handle, int v);
+    void SetUniform1f(UniformHandle handle, float v);
+    void SetUniformMat4f(UniformHandle handle, const glm::mat4& m);
+    void SetUniform4fv(UniformHandle handle, const glm::vec4& vec);
+    void SetUniform3fv(UniformHandle handle, const glm::vec3& vec);
+
+    // The same by name, one hash table lookup per set
+    void SetUniform4f(UniformName name, float v0, float v1, float v2,
+        float v3) {
+        SetUniform4f(GetUniformHandle(name), v0, v1, v2, v3);
+    }
+    void SetUniform1i(UniformName name, int v) {
+        SetUniform1i(GetUniformHandle(name), v);
+    }
+    void SetUniform1f(UniformName name, float v) {
+        SetUniform1f(GetUniformHandle(name), v);
+    }
+    void SetUniformMat4f(UniformName name, const glm::mat4& m) {
+        SetUniformMat4f(GetUniformHandle(name), m);
+    }
+    void SetUniform4fv(UniformName name, const glm::vec4& vec) {
+        SetUniform4fv(GetUniformHandle(name), vec);
+    }
+    void SetUniform3fv(UniformName name, const glm::vec3& vec) {
+        SetUniform3fv(GetUniformHandle(name), vec);
+    }
+
+    // Whether the program takes its model matrix from the a_InstanceModel
+    // attribute when u_Instanced is set, see RenderQueue.
+    bool SupportsInstancing();
+
+    // Name of the block in GLSL
+    static const char* GetUniformBlockName(EUniformBlock block);
 
     static std::string GetDefaultShaderPath(EDefaultShader shaderType);
+    // The shared program of shaderType, see ShaderLibrary.
     static ShaderPtr GetDefaultShader(EDefaultShader shaderType);
 
 private:
-    int GetUniformLocation(const std::string& name);
+    // A program whose link was not checked yet, with its shader objects and
+    // sources. No shader objects: it was loaded from ProgramBinaryCache.
+    struct PendingLink {
+        GLuint program = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        GLuint geometryShader = 0;
+        // ProgramBinaryCache key and sources
+        std::string cacheKey;
+        std::string programSource;
+    };
+    mutable std::optional<PendingLink> m_PendingLink;
+    std::optional<PendingLink> m_PendingReload;
+    std::string m_FilePath;
+    std::vector<std::string> m_Defines;
+
+    // Issue the compiles and the link of a program, see PendingLink.
+    static PendingLink BuildProgram(const std::string& filePath,
+        const std::vector<std::string>& defines);
+    // Whether waiting on build would not block.
+    static bool IsLinkComplete(const PendingLink& build);
+    // Report the errors of build and release its shader objects; returns
+    // whether it linked.
+    static bool FinishLink(const PendingLink& build);
+    static void DeleteShaders(const PendingLink& build);
+
+    // The hash is already well mixed.
+    struct UniformHashIdentity {
+        size_t operator()(uint64_t hash) const {
+            return static_cast<size_t>(hash);
+        }
+    };
+    // Names and locations by handle index, handles by name hash, and the
+    // active uniforms of the linked program by name hash.
+    struct UniformTable {
+        std::vector<std::string> names;
+        std::vector<GLint> locations;
+        std::unordered_map<uint64_t, uint32_t, UniformHashIdentity> handles;
+        std::unordered_map<uint64_t, GLint, UniformHashIdentity> active;
+    };
+    // Filled when the link is checked, which a const Bind may do.
+    mutable UniformTable m_Uniforms;
+
+    GLint GetUniformLocation(UniformHandle handle) const;
+    GLint FindActiveUniform(uint64_t hash) const;
+    // Read the active uniforms with glGetActiveUniform and resolve every
+    // handle against them; attach the EUniformBlock blocks.
+    void ReflectUniforms() const;
 
     static void CheckForCompilationErrors(unsigned int shaderID,
         const std::string& context = "");
+    static bool CheckForLinkErrors(unsigned int programID);
 };
@@ -0,0 +1,95 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <system_error>
+
+std::string ShaderLibrary::MakeKey(const std::string& filePath, std::vector<std::string> defines) {
+    std::sort(defines.begin(), defines.end());
+    // '\n' cannot appear in a path nor in a single-line define, so distinct inputs give distinct keys.
+    std::string key = filePath;
+    for (const std::string& define : defines) {
+        key += '\n';
+        key += define;
+    }
+    return key;
+}
+
+ShaderPtr ShaderLibrary::Get(const std::string& filePath, const std::vector<std::string>& defines) {
+    auto [it, bInserted] = m_Programs.try_emplace(MakeKey(filePath, defines));
+    if (!bInserted) {
+        m_HitCount++;
+        return it->second;
+    }
+    std::error_code error;
+    m_WriteTimes.try_emplace(filePath, std::filesystem::last_write_time(filePath, error));
+    it->second = std::make_shared<Shader>(filePath, defines);
+    m_CompileCount++;
+    return it->second;
+}
+
+ShaderPtr ShaderLibrary::Get(EDefaultShader shaderType, const std::vector<std::string>& defines) {
+    return Get(Shader::GetDefaultShaderPath(shaderType), defines);
+}
+
+void ShaderLibrary::Preload(const std::vector<std::string>& filePaths, const std::vector<std::string>& defines) {
+    for (const std::string& filePath : filePaths) {
+        Get(filePath, defines);
+    }
+}
+
+bool ShaderLibrary::IsReady() {
+    bool bReady = true;
+    for (auto& [key, shader] : m_Programs) {
+        // No early out: polling finishes the programs that are done.
+        bReady = shader->IsReady() && bReady;
+    }
+    return bReady;
+}
+
+size_t ShaderLibrary::Update() {
+    if (m_bHotReload && std::chrono::steady_clock::now() - m_LastPoll >= kPollInterval) {
+        m_LastPoll = std::chrono::steady_clock::now();
+        PollFiles();
+    }
+    size_t swapped = 0;
+    for (auto& [key, shader] : m_Programs) {
+        if (shader->IsReloading() && shader->ApplyReload()) {
+            swapped++;
+        }
+    }
+    return swapped;
+}
+
+void ShaderLibrary::PollFiles() {
+    for (auto& [filePath, writeTime] : m_WriteTimes) {
+        std::error_code error;
+        const auto currentWriteTime = std::filesystem::last_write_time(filePath, error);
+        // A file being saved can be missing for a moment; it is picked up on a later poll.
+        if (error || currentWriteTime == writeTime) {
+            continue;
+        }
+        writeTime = currentWriteTime;
+        for (auto& [key, shader] : m_Programs) {
+            if (shader->GetFilePath() == filePath) {
+                shader->Reload();
+            }
+        }
+    }
+}
+
+bool ShaderLibrary::Contains(const std::string& filePath, const std::vector<std::string>& defines) const {
+    return m_Programs.find(MakeKey(filePath, defines)) != m_Programs.end();
+}
+
+size_t ShaderLibrary::ReleaseUnused() {
+    size_t released = 0;
+    for (auto it = m_Programs.begin(); it != m_Programs.end();) {
+        if (it->second.use_count() == 1) {
+            it = m_Programs.erase(it);
+            released++;
+        } else {
+            ++it;
+        }
+    }
+    return released;
+}
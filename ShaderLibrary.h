@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+/**
+ * Compiled shader programs keyed by source file and preprocessor defines, so that every mesh asking for the same shader
+ * shares one program instead of compiling and linking its own. Sharing is safe because a program holds no per-mesh
+ * state between draws: per-mesh values are set by Mesh::ApplyUniforms before each draw, and the camera comes from the
+ * Camera uniform block.
+ * Programs stay alive while the library holds them, see ReleaseUnused. The library is used from the GL thread only.
+ */
+class ShaderLibrary {
+public:
+    static constexpr std::chrono::milliseconds kPollInterval{250};
+
+    /**
+     * The program of filePath compiled with defines, compiling it on the first request.
+     * @param defines one "NAME" or "NAME value" per entry, inserted as #define lines after the #version line of every
+     * stage. Their order does not matter.
+     */
+    ShaderPtr Get(const std::string& filePath, const std::vector<std::string>& defines = {});
+    ShaderPtr Get(EDefaultShader shaderType, const std::vector<std::string>& defines = {});
+
+    /**
+     * Issue the compiles of all filePaths before checking any, so that a driver with GL_KHR_parallel_shader_compile
+     * builds them at once; a program only waits for its link when it is first used.
+     */
+    void Preload(const std::vector<std::string>& filePaths, const std::vector<std::string>& defines = {});
+    /** Whether every program is linked, see Shader::IsReady. */
+    bool IsReady();
+
+    /**
+     * Watch the source files of the library's programs: once a file's write time changes, its programs are rebuilt
+     * through the deferred path while the old ones keep drawing. Programs made outside the library are not watched.
+     */
+    void SetHotReload(bool bHotReload) { m_bHotReload = bHotReload; }
+    bool IsHotReload() const { return m_bHotReload; }
+    /**
+     * Call once per frame, between frames. With hot reload on, checks the watched files at most every kPollInterval and
+     * starts rebuilding the programs of the changed ones; then swaps in every rebuild that has finished. A rebuild that
+     * fails to compile is dropped and its program keeps the previous version. Returns the number of programs swapped.
+     */
+    size_t Update();
+
+    bool Contains(const std::string& filePath, const std::vector<std::string>& defines = {}) const;
+
+    /** Drop the programs nobody else references; they are deleted with their last ShaderPtr. Returns how many. */
+    size_t ReleaseUnused();
+    void Clear() { m_Programs.clear(); }
+
+    size_t GetProgramCount() const { return m_Programs.size(); }
+    /** Programs compiled since construction, i.e. cache misses. */
+    size_t GetCompileCount() const { return m_CompileCount; }
+    size_t GetHitCount() const { return m_HitCount; }
+
+    /** The library behind Shader::GetDefaultShader. */
+    static ShaderLibrary& GetGlobal() {
+        static ShaderLibrary library;
+        return library;
+    }
+
+    static std::string MakeKey(const std::string& filePath, std::vector<std::string> defines);
+
+private:
+    /** Start rebuilding the programs whose file changed since the last poll. */
+    void PollFiles();
+
+    std::unordered_map<std::string, ShaderPtr> m_Programs;
+    // Write time of each watched file when it was last built.
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_WriteTimes;
+    std::chrono::steady_clock::time_point m_LastPoll;
+    bool m_bHotReload = false;
+    size_t m_CompileCount = 0;
+    size_t m_HitCount = 0;
+};
@@ -1,9 +1,14 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "Interfaces.h"
 #include "Mesh.h"
 #include "MeshUtils.h"
+#include "TransformNode.h"
 #include "glm/gtx/string_cast.hpp"
 
 struct Transform {
@@ -12,6 +17,13 @@ struct Transform {
     glm::vec3 scale;
 };
 
+/** One level of detail: drawn while the shape covers at least minScreenSize of the viewport height. */
+template <class Vertex>
+struct ShapeLod {
+    MeshPtr<Vertex> mesh;
+    float minScreenSize = 0.0f;
+};
+
 template <class Vertex>
 class Shape : public Drawable {
 public:
@@ -20,6 +32,8 @@ public:
     Shape(EMeshType meshType = EMeshType::MESH_SOLID_COLOR, const glm::vec3& location = glm::vec3(0.0f),
         EBasicGeometry geometry = EBasicGeometry::CUBE, EDefaultShader shader = EDefaultShader::NONE);
     virtual void Draw(CameraPtr Camera) override;
+    /** Queue the mesh Draw would draw, with the model matrix as u_Model. */
+    virtual bool Submit(RenderQueue& queue, const CameraPtr& camera) override;
     virtual void Update() override;
     void SetLocation(const glm::vec3& newLocation);
     void AddLocation(const glm::vec3& deltaLocation);
@@ -28,9 +42,16 @@ public:
     void AddRotation(float degree, glm::vec3 rotationAxis);
     void SetRotation(float degree, glm::vec3 rotationAxis);
 
-    glm::vec3 GetLocation() const { return m_TranslationMatrix[3]; }
-    glm::mat4 GetRotationMatrix() const { return m_RotationMatrix; }
-    glm::vec3 GetScale() const { return {m_ScaleMatrix[0][0], m_ScaleMatrix[1][1], m_ScaleMatrix[2][2]}; }
+    glm::vec3 GetLocation() const { return m_Transform.GetLocation(); }
+    glm::mat4 GetRotationMatrix() const { return m_Transform.GetRotationMatrix(); }
+    glm::vec3 GetScale() const { return m_Transform.GetScale(); }
+
+    /**
+     * The shape's node in the transform hierarchy; the setters above change its local transform. Parent it to another
+     * shape's node, or to a node of its own, to move compound objects as one.
+     */
+    TransformNode& GetTransform() { return m_Transform; }
+    const TransformNode& GetTransform() const { return m_Transform; }
 
     void SetUpdateMethod(const std::function<void()>& updateMethod);
 
@@ -38,6 +59,15 @@ public:
 
     MeshPtr<Vertex> GetBaseMesh() const { return m_Mesh; }
 
+    /**
+     * Pick the mesh to draw every frame from the shape's size on screen, see Camera::GetScreenSize.
+     * lods go from most to least detailed with decreasing minScreenSize; the last one is drawn at any size below.
+     * bounds encloses the geometry in model space, scaled and moved with the shape. The base mesh becomes lods[0].
+     */
+    void SetLods(std::vector<ShapeLod<Vertex>> lods, const BoundingSphere& bounds);
+    /** Level drawn in the last frame, 0 without LODs. */
+    size_t GetLodIndex() const { return m_LodIndex; }
+
     template <template <class> class MeshClass>
     std::shared_ptr<MeshClass<Vertex>> GetMesh() const {
         return std::dynamic_pointer_cast<MeshClass<Vertex>>(m_Mesh);
@@ -46,14 +76,18 @@ public:
 private:
     MeshPtr<Vertex> m_Mesh;
 
-    glm::mat4 m_ModelMatrix = glm::mat4(1.0f);
-    glm::mat4 m_RotationMatrix = glm::mat4(1.0f);
-    glm::mat4 m_TranslationMatrix = glm::mat4(1.0f);
-    glm::mat4 m_ScaleMatrix = glm::mat4(1.0f);
+    std::vector<ShapeLod<Vertex>> m_Lods;
+    BoundingSphere m_Bounds;
+    size_t m_LodIndex = 0;
+
+    TransformNode m_Transform;
 
     std::function<void()> m_UpdateMethod;
 
-    void ApplyModelMatrix();
+    void ApplyModelMatrix(Mesh<Vertex>& mesh);
+    /** Update the level of detail for this frame and return the mesh to draw. */
+    Mesh<Vertex>& PrepareDraw(const Camera& camera);
+    size_t SelectLod(const Camera& camera) const;
 };
 
 
@@ -82,31 +116,31 @@ void Shape<Vertex>::SetUpdateMethod(const std::function<void()>& updateMethod) {
 
 template <class Vertex>
 void Shape<Vertex>::SetRotation(float degree, glm::vec3 rotationAxis) {
-    m_RotationMatrix = glm::mat4(1.0f);
-    AddRotation(degree, rotationAxis);
+    m_Transform.SetRotation(degree, rotationAxis);
 }
 
 template <class Vertex>
 void Shape<Vertex>::AddRotation(float degree, glm::vec3 rotationAxis) {
-    m_RotationMatrix = glm::rotate(m_RotationMatrix, glm::radians(degree), rotationAxis);
+    m_Transform.AddRotation(degree, rotationAxis);
 }
 
 template <class Vertex>
 void Shape<Vertex>::SetScale(const glm::vec3& scale) {
-
-    m_ScaleMatrix = glm::mat4(1.0f);
-    AddScale(scale);
+    m_Transform.SetScale(scale);
 }
 
 template <class Vertex>
 void Shape<Vertex>::AddScale(const glm::vec3& scale) {
-    m_ScaleMatrix = glm::scale(m_ScaleMatrix, scale);
+    m_Transform.AddScale(scale);
 }
 
 template <class Vertex>
 
 void Shape<Vertex>::Update() {
     m_Mesh->Update();
+    for (size_t lod = 1; lod < m_Lods.size(); lod++) {
+        m_Lods[lod].mesh->Update();
+    }
 
     if (m_UpdateMethod) {
         m_UpdateMethod();
@@ -119,27 +153,67 @@ Shape<Vertex>::Shape(MeshPtr<Vertex> mesh, const glm::vec3& location /*= glm::ve
     SetLocation(location);
 }
 
+template <class Vertex>
+Mesh<Vertex>& Shape<Vertex>::PrepareDraw(const Camera& camera) {
+    m_LodIndex = m_Lods.empty() ? 0 : SelectLod(camera);
+    return m_Lods.empty() ? *m_Mesh : *m_Lods[m_LodIndex].mesh;
+}
+
 template <class Vertex>
 void Shape<Vertex>::Draw(CameraPtr Camera) {
-    ApplyModelMatrix();
-    m_Mesh->Draw(Camera);
+    Mesh<Vertex>& mesh = PrepareDraw(*Camera);
+    ApplyModelMatrix(mesh);
+    mesh.Draw(Camera);
+}
+
+template <class Vertex>
+bool Shape<Vertex>::Submit(RenderQueue& queue, const CameraPtr& camera) {
+    Mesh<Vertex>& mesh = PrepareDraw(*camera);
+    if (!mesh.IsUploading()) {
+        queue.Add(mesh, m_Transform.GetWorldMatrix() * mesh.GetDecodeMatrix());
+    }
+    return true;
+}
+
+template <class Vertex>
+void Shape<Vertex>::SetLods(std::vector<ShapeLod<Vertex>> lods, const BoundingSphere& bounds) {
+    m_Lods = std::move(lods);
+    m_Bounds = bounds;
+    m_LodIndex = 0;
+    if (!m_Lods.empty()) {
+        m_Mesh = m_Lods.front().mesh;
+    }
+}
+
+template <class Vertex>
+size_t Shape<Vertex>::SelectLod(const Camera& camera) const {
+    const glm::mat4& world = m_Transform.GetWorldMatrix();
+    const glm::vec3 center = glm::vec3(world * glm::vec4(m_Bounds.center, 1.0f));
+    // Longest axis of the world matrix, so that parents' scales count too.
+    const float scale = std::max({glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))});
+    const float radius = m_Bounds.radius * scale;
+    const float screenSize = camera.GetScreenSize(center, radius);
+    for (size_t lod = 0; lod + 1 < m_Lods.size(); lod++) {
+        if (screenSize >= m_Lods[lod].minScreenSize) {
+            return lod;
+        }
+    }
+    return m_Lods.size() - 1;
 }
 
 template <class Vertex>
 void Shape<Vertex>::SetLocation(const glm::vec3& newLocation) {
-    m_TranslationMatrix = glm::mat4(1.0f);
-    AddLocation(newLocation);
+    m_Transform.SetLocation(newLocation);
 }
 
 template <class Vertex>
 void Shape<Vertex>::AddLocation(const glm::vec3& deltaLocation) {
-    m_TranslationMatrix = glm::translate(m_TranslationMatrix, deltaLocation);
+    m_Transform.AddLocation(deltaLocation);
 }
 
 template <class Vertex>
-void Shape<Vertex>::ApplyModelMatrix() {
-    m_ModelMatrix = m_TranslationMatrix * m_RotationMatrix * m_ScaleMatrix;
-    m_Mesh->GetShader()->SetUniformMat4f("u_Model", m_ModelMatrix);
+void Shape<Vertex>::ApplyModelMatrix(Mesh<Vertex>& mesh) {
+    mesh.GetShader()->SetUniformMat4f("u_Model", m_Transform.GetWorldMatrix() * mesh.GetDecodeMatrix());
 }
 
 template <class Vertex>
@@ -2,15 +2,26 @@
 
 #include "stbimage/stb_image.h"
 
+ImageData ImageData::Load(const std::string& path) {
+  // stbi_set_flip_vertically_on_load(true);
+  ImageData image;
+  unsigned char* pixels =
+      stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 4);
+  if (pixels) {
+    image.pixels.reset(pixels, stbi_image_free);
+  }
+  return image;
+}
+
 Texture::Texture(const std::string& path)
+    : Texture(ImageData::Load(path), path) {}
+
+Texture::Texture(const ImageData& image, const std::string& path)
     : m_ID(0),
       m_FilePath(path),
-      m_LocalBuffer(nullptr),
-      m_Width(0),
-      m_Height(0),
-      m_BPP(0) {
-  // stbi_set_flip_vertically_on_load(true);
-  m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+      m_Width(image.width),
+      m_Height(image.height),
+      m_BPP(image.channels) {
   glGenTextures(1, &m_ID);
   glBindTexture(GL_TEXTURE_2D, m_ID);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -19,15 +30,12 @@ Texture::Texture(const std::string& path)
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, m_LocalBuffer);
-  if (!m_RetainLocalBuffer) {
-    stbi_image_free(m_LocalBuffer);
+               GL_UNSIGNED_BYTE, image.pixels.get());
+  if (m_RetainLocalBuffer) {
+    m_Image = image;
   }
 }
 Texture::~Texture() {
-  if (m_RetainLocalBuffer) {
-    stbi_image_free(m_LocalBuffer);
-  }
   glDeleteTextures(1, &m_ID);
 }
 void Texture::Bind(unsigned int slot) const {
@@ -1,19 +1,37 @@
 #pragma once
 #include <glad/glad.h>
 
+#include <memory>
 #include <string>
+
+// Decoded RGBA8 pixels. Decoding touches no GL state, so it can run on any
+// thread; the pixels are freed with the last copy.
+struct ImageData {
+  std::shared_ptr<unsigned char> pixels;
+  int width = 0;
+  int height = 0;
+  // Channels in the file, pixels always hold 4
+  int channels = 0;
+
+  bool IsValid() const { return pixels != nullptr; }
+
+  static ImageData Load(const std::string& path);
+};
+
 class Texture {
  public:
   unsigned int m_ID;
 
  private:
   std::string m_FilePath;
-  unsigned char* m_LocalBuffer;
+  ImageData m_Image;
   int m_Width, m_Height, m_BPP;
   bool m_RetainLocalBuffer = false;
 
  public:
   Texture(const std::string& path);
+  // Upload an already decoded image, e.g. one decoded by AssetLoader
+  Texture(const ImageData& image, const std::string& path = "");
   ~Texture();
 
   void Bind(unsigned int slot = 0) const;
@@ -22,3 +40,5 @@ class Texture {
   inline int GetWidth() const { return m_Width; }
   inline int GetHeight() const { return m_Height; }
 };
+
+using TexturePtr = std::shared_ptr<Texture>;
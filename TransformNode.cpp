@@ -0,0 +1,108 @@
+#include "TransformNode.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+TransformNode::TransformNode(const TransformNode& other)
+    : m_Translation(other.m_Translation),
+      m_Rotation(other.m_Rotation),
+      m_Scale(other.m_Scale),
+      m_bLocalDirty(true),
+      m_bWorldDirty(true) {
+}
+
+TransformNode& TransformNode::operator=(const TransformNode& other) {
+    m_Translation = other.m_Translation;
+    m_Rotation = other.m_Rotation;
+    m_Scale = other.m_Scale;
+    MarkLocalDirty();
+    return *this;
+}
+
+TransformNode::~TransformNode() {
+    SetParent(nullptr);
+    for (TransformNode* child : m_Children) {
+        child->m_Parent = nullptr;
+        child->MarkWorldDirty();
+    }
+}
+
+void TransformNode::SetLocation(const glm::vec3& location) {
+    m_Translation = glm::translate(glm::mat4(1.0f), location);
+    MarkLocalDirty();
+}
+
+void TransformNode::AddLocation(const glm::vec3& deltaLocation) {
+    m_Translation = glm::translate(m_Translation, deltaLocation);
+    MarkLocalDirty();
+}
+
+void TransformNode::SetRotation(float degree, const glm::vec3& rotationAxis) {
+    m_Rotation = glm::rotate(glm::mat4(1.0f), glm::radians(degree), rotationAxis);
+    MarkLocalDirty();
+}
+
+void TransformNode::AddRotation(float degree, const glm::vec3& rotationAxis) {
+    m_Rotation = glm::rotate(m_Rotation, glm::radians(degree), rotationAxis);
+    MarkLocalDirty();
+}
+
+void TransformNode::SetScale(const glm::vec3& scale) {
+    m_Scale = glm::scale(glm::mat4(1.0f), scale);
+    MarkLocalDirty();
+}
+
+void TransformNode::AddScale(const glm::vec3& scale) {
+    m_Scale = glm::scale(m_Scale, scale);
+    MarkLocalDirty();
+}
+
+const glm::mat4& TransformNode::GetLocalMatrix() const {
+    if (m_bLocalDirty) {
+        m_LocalMatrix = m_Translation * m_Rotation * m_Scale;
+        m_bLocalDirty = false;
+    }
+    return m_LocalMatrix;
+}
+
+const glm::mat4& TransformNode::GetWorldMatrix() const {
+    if (m_bWorldDirty) {
+        m_WorldMatrix = m_Parent ? m_Parent->GetWorldMatrix() * GetLocalMatrix() : GetLocalMatrix();
+        m_bWorldDirty = false;
+    }
+    return m_WorldMatrix;
+}
+
+void TransformNode::SetParent(TransformNode* parent) {
+    if (parent == m_Parent) {
+        return;
+    }
+    if (m_Parent) {
+        m_Parent->RemoveChild(this);
+    }
+    m_Parent = parent;
+    if (m_Parent) {
+        m_Parent->m_Children.push_back(this);
+    }
+    MarkWorldDirty();
+}
+
+void TransformNode::MarkLocalDirty() {
+    m_bLocalDirty = true;
+    MarkWorldDirty();
+}
+
+void TransformNode::MarkWorldDirty() {
+    if (m_bWorldDirty) {
+        return;
+    }
+    m_bWorldDirty = true;
+    for (TransformNode* child : m_Children) {
+        child->MarkWorldDirty();
+    }
+}
+
+void TransformNode::RemoveChild(TransformNode* child) {
+    m_Children.erase(std::find(m_Children.begin(), m_Children.end(), child));
+}
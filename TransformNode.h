@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Translation, rotation and scale of an object relative to its parent node, and its world matrix: parent's world matrix
+ * times translation * rotation * scale. Both matrices are cached. Changing a node marks its world matrix and those of
+ * its descendants dirty, and a dirty matrix is recomputed on the next GetWorldMatrix, so a frame only pays for the
+ * subtrees that moved.
+ * Parents and children point at each other without owning: a node leaves its parent and orphans its children when it is
+ * destroyed. A copy has the same local transform but no parent and no children. Nodes are used from one thread.
+ */
+class TransformNode {
+public:
+    TransformNode() = default;
+    TransformNode(const TransformNode& other);
+    TransformNode& operator=(const TransformNode& other);
+    ~TransformNode();
+
+    void SetLocation(const glm::vec3& location);
+    void AddLocation(const glm::vec3& deltaLocation);
+    void SetRotation(float degree, const glm::vec3& rotationAxis);
+    void AddRotation(float degree, const glm::vec3& rotationAxis);
+    void SetScale(const glm::vec3& scale);
+    void AddScale(const glm::vec3& scale);
+
+    glm::vec3 GetLocation() const { return m_Translation[3]; }
+    const glm::mat4& GetRotationMatrix() const { return m_Rotation; }
+    glm::vec3 GetScale() const { return {m_Scale[0][0], m_Scale[1][1], m_Scale[2][2]}; }
+
+    /** translation * rotation * scale. */
+    const glm::mat4& GetLocalMatrix() const;
+    /** Parent's world matrix times the local matrix; the local matrix for a root. */
+    const glm::mat4& GetWorldMatrix() const;
+    /** Whether GetWorldMatrix has to recompute, i.e. this node or an ancestor changed since it last did. */
+    bool IsWorldDirty() const { return m_bWorldDirty; }
+
+    /** Move this node under parent, or make it a root with nullptr. Its local transform is kept, not its world one. */
+    void SetParent(TransformNode* parent);
+    TransformNode* GetParent() const { return m_Parent; }
+    const std::vector<TransformNode*>& GetChildren() const { return m_Children; }
+
+private:
+    void MarkLocalDirty();
+    /** Mark this node and its descendants; stops at dirty nodes, whose descendants are dirty already. */
+    void MarkWorldDirty();
+    void RemoveChild(TransformNode* child);
+
+    glm::mat4 m_Translation = glm::mat4(1.0f);
+    glm::mat4 m_Rotation = glm::mat4(1.0f);
+    glm::mat4 m_Scale = glm::mat4(1.0f);
+
+    mutable glm::mat4 m_LocalMatrix = glm::mat4(1.0f);
+    mutable glm::mat4 m_WorldMatrix = glm::mat4(1.0f);
+    mutable bool m_bLocalDirty = false;
+    mutable bool m_bWorldDirty = false;
+
+    TransformNode* m_Parent = nullptr;
+    std::vector<TransformNode*> m_Children;
+};
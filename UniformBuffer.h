@@ -0,0 +1,55 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <type_traits>
+
+/**
+ * One Block of uniforms in a buffer, bound to a fixed binding point. Programs attach their uniform block of the same name
+ * to that point when they link (see EUniformBlock), so one upload serves every program. Block has to match the std140
+ * layout of its GLSL declaration: vec3 members padded to vec4, matrices as four vec4 columns.
+ */
+template <class Block>
+class UniformBuffer {
+    static_assert(std::is_trivially_copyable_v<Block>, "Uniform blocks are uploaded as raw bytes");
+
+public:
+    // Reference ID of the Uniform Buffer Object
+    GLuint m_ID;
+
+    explicit UniformBuffer(GLuint binding);
+
+    void SetData(const Block& block);
+    // Attach the buffer to its binding point, e.g. after another buffer was bound there
+    void Bind() const;
+    void Delete() const;
+
+    GLuint GetBinding() const { return m_Binding; }
+
+private:
+    GLuint m_Binding;
+};
+
+template <class Block>
+UniformBuffer<Block>::UniformBuffer(GLuint binding)
+    : m_Binding(binding) {
+    glGenBuffers(1, &m_ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+    Bind();
+}
+
+template <class Block>
+void UniformBuffer<Block>::SetData(const Block& block) {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+}
+
+template <class Block>
+void UniformBuffer<Block>::Bind() const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_ID);
+}
+
+template <class Block>
+void UniformBuffer<Block>::Delete() const {
+    glDeleteBuffers(1, &m_ID);
+}
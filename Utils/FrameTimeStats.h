@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Frame times of a run, reported as percentiles: an average hides the few long frames that loading causes.
+ */
+class FrameTimeStats {
+public:
+    void AddFrame(double ms) { m_FrameMs.push_back(ms); }
+    void Reset() { m_FrameMs.clear(); }
+    size_t GetFrameCount() const { return m_FrameMs.size(); }
+
+    /** Nearest-rank percentile, percent in [0, 100]. 0 without frames. */
+    double Percentile(double percent) const;
+    double Max() const { return m_FrameMs.empty() ? 0.0 : *std::max_element(m_FrameMs.begin(), m_FrameMs.end()); }
+
+    /** "p50 .. ms, p95 .. ms, p99 .. ms, max .. ms" */
+    std::string ToString() const;
+
+private:
+    std::vector<double> m_FrameMs;
+};
+
+inline double FrameTimeStats::Percentile(double percent) const {
+    if (m_FrameMs.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sorted = m_FrameMs;
+    const auto rank = static_cast<size_t>(std::ceil(percent / 100.0 * sorted.size()));
+    const size_t index = std::clamp<size_t>(rank, 1, sorted.size()) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+inline std::string FrameTimeStats::ToString() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "p50 " << Percentile(50) << " ms, p95 " << Percentile(95) << " ms, p99 "
+        << Percentile(99) << " ms, max " << Max() << " ms";
+    return out.str();
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Read-only memory mapping of a whole file.
+ * Parsers can walk [begin(), end()) directly without copying the file into a std::string.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { Open(path); }
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return m_Data != nullptr || m_bOpenedEmpty; }
+    const char* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+
+    const char* begin() const { return m_Data; }
+    const char* end() const { return m_Data + m_Size; }
+
+private:
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    // mmap refuses zero-length mappings, but an empty file is still a valid file.
+    bool m_bOpenedEmpty = false;
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#endif
+};
+
+inline MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        m_Data = other.m_Data;
+        m_Size = other.m_Size;
+        m_bOpenedEmpty = other.m_bOpenedEmpty;
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        other.m_bOpenedEmpty = false;
+#ifdef _WIN32
+        m_File = other.m_File;
+        m_Mapping = other.m_Mapping;
+        other.m_File = INVALID_HANDLE_VALUE;
+        other.m_Mapping = nullptr;
+#endif
+    }
+    return *this;
+}
+
+inline bool MappedFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_File, &fileSize)) {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_Size == 0) {
+        m_bOpenedEmpty = true;
+        return true;
+    }
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping) {
+        Close();
+        return false;
+    }
+    m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_Data) {
+        Close();
+        return false;
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return false;
+    }
+    m_Size = static_cast<size_t>(fileStat.st_size);
+    if (m_Size == 0) {
+        close(fd);
+        m_bOpenedEmpty = true;
+        return true;
+    }
+    void* mapped = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        m_Size = 0;
+        return false;
+    }
+    madvise(mapped, m_Size, MADV_SEQUENTIAL);
+    m_Data = static_cast<const char*>(mapped);
+#endif
+    return true;
+}
+
+inline void MappedFile::Close() {
+#ifdef _WIN32
+    if (m_Data) {
+        UnmapViewOfFile(m_Data);
+    }
+    if (m_Mapping) {
+        CloseHandle(m_Mapping);
+    }
+    if (m_File != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_File);
+    }
+    m_Mapping = nullptr;
+    m_File = INVALID_HANDLE_VALUE;
+#else
+    if (m_Data) {
+        munmap(const_cast<char*>(m_Data), m_Size);
+    }
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+    m_bOpenedEmpty = false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * Resident set size of the current process in bytes, 0 if it cannot be queried.
+ * Kept out of Profile.h so that only the code measuring memory pulls in the platform headers.
+ */
+inline size_t GetResidentSetBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long totalPages = 0, residentPages = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &totalPages, &residentPages);
+    std::fclose(statm);
+    return fields == 2 ? residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
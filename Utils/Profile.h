@@ -27,6 +27,22 @@ private:
 	steady_clock::time_point start;
 };
 
+class Timer {
+public:
+	Timer()
+		: start(steady_clock::now())
+	{
+	}
+
+	void Reset() { start = steady_clock::now(); }
+
+	double ElapsedMs() const {
+		return duration<double, milli>(steady_clock::now() - start).count();
+	}
+private:
+	steady_clock::time_point start;
+};
+
 #define UNIQ_ID_IMPL(lineno) _a_local_var_##lineno
 #define UNIQ_ID(lineno) UNIQ_ID_IMPL(lineno)
 
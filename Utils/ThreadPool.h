@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed set of worker threads consuming a FIFO task queue.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Queue a task; the future becomes ready once a worker has run it. */
+    template <class Task>
+    auto Submit(Task&& task) -> std::future<std::invoke_result_t<Task>>;
+
+    /**
+     * Run task(i) for every i in [0, count) and wait for all of them.
+     * The calling thread takes part, so it is safe to call from inside a pool task.
+     */
+    template <class Task>
+    void ParallelFor(size_t count, Task&& task);
+
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Workers.size()); }
+
+    /** Process-wide pool sized to the hardware concurrency. */
+    static ThreadPool& GetGlobal() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_Workers;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_TaskAdded;
+    bool m_bStopping = false;
+};
+
+inline ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_Workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_Workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStopping = true;
+    }
+    m_TaskAdded.notify_all();
+    for (auto& worker : m_Workers) {
+        worker.join();
+    }
+}
+
+inline void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_TaskAdded.wait(lock, [this]() { return m_bStopping || !m_Tasks.empty(); });
+            if (m_bStopping && m_Tasks.empty()) {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
+
+template <class Task>
+auto ThreadPool::Submit(Task&& task) -> std::future<std::invoke_result_t<Task>> {
+    using Result = std::invoke_result_t<Task>;
+    // std::function needs a copyable callable, packaged_task is move-only.
+    auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+    std::future<Result> result = packagedTask->get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.emplace([packagedTask]() { (*packagedTask)(); });
+    }
+    m_TaskAdded.notify_one();
+    return result;
+}
+
+template <class Task>
+void ThreadPool::ParallelFor(size_t count, Task&& task) {
+    if (count == 0) {
+        return;
+    }
+    struct SharedState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    // Helpers may be dequeued after the loop is over, so they must not reference this stack frame.
+    auto state = std::make_shared<SharedState>();
+    auto taskPtr = std::make_shared<std::decay_t<Task>>(std::forward<Task>(task));
+    auto runItems = [state, taskPtr, count]() {
+        size_t i;
+        while ((i = state->next.fetch_add(1)) < count) {
+            (*taskPtr)(i);
+            if (state->done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min<size_t>(count, GetThreadCount()) - 1;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (size_t i = 0; i < helpers; i++) {
+            m_Tasks.emplace(runItems);
+        }
+    }
+    m_TaskAdded.notify_all();
+
+    runItems();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done.load() == count; });
+}
@@ -10,8 +10,16 @@ class VertexArray {
   // Ctor that generates a VAO ID
   VertexArray();
 
+  // Bind vbo with the compile-time layout of Vertex, see kVertexAttributes.
+  void AddBuffer(const VertexBuffer<Vertex>& vbo);
   void AddBuffer(const VertexBuffer<Vertex>& vbo,
                  const VertexBufferLayout& layout);
+  // Source the attributes of layout from vbo, numbered from firstAttribute;
+  // for geometry kept as one buffer per attribute (GeometrySoA).
+  template <class Element>
+  void AddBuffer(const VertexBuffer<Element>& vbo,
+                 const VertexBufferLayout& layout,
+                 unsigned int firstAttribute);
   void Bind() const;
   void UnBind() const;
   void Delete() const;
@@ -23,19 +31,43 @@ VertexArray<Vertex>::VertexArray() {
   glGenVertexArrays(1, &m_ID);
 }
 
+template <class Vertex>
+void VertexArray<Vertex>::AddBuffer(const VertexBuffer<Vertex>& vb) {
+  static_assert(IsVertexLayoutPacked<Vertex>(),
+                "kVertexAttributes<Vertex> does not match the members");
+  Bind();
+  vb.Bind();
+  for (unsigned int i = 0; i < kVertexAttributes<Vertex>.size(); i++) {
+    const VertexAttribute& attribute = kVertexAttributes<Vertex>[i];
+    glEnableVertexAttribArray(i);
+    glVertexAttribPointer(i, attribute.element.count, attribute.element.type,
+                          attribute.element.normalized, sizeof(Vertex),
+                          (const void*)(size_t)attribute.offset);
+  }
+}
+
 template <class Vertex>
 void VertexArray<Vertex>::AddBuffer(const VertexBuffer<Vertex>& vb,
                                     const VertexBufferLayout& layout) {
+  AddBuffer(vb, layout, 0);
+}
+
+template <class Vertex>
+template <class Element>
+void VertexArray<Vertex>::AddBuffer(const VertexBuffer<Element>& vb,
+                                    const VertexBufferLayout& layout,
+                                    unsigned int firstAttribute) {
   Bind();
   vb.Bind();
   const auto& elements = layout.GetElements();
   unsigned int offset = 0;
   for (unsigned int i = 0; i < elements.size(); i++) {
     const auto& element = elements[i];
-    glEnableVertexAttribArray(i);
-    glVertexAttribPointer(i, element.count, element.type, element.normalized,
-                          layout.GetStride(), (const void*)offset);
-    offset += element.count * VertexBufferElement::GetSize(element.type);
+    glEnableVertexAttribArray(firstAttribute + i);
+    glVertexAttribPointer(firstAttribute + i, element.count, element.type,
+                          element.normalized, layout.GetStride(),
+                          (const void*)offset);
+    offset += element.GetByteSize();
   }
 }
 template <class Vertex>
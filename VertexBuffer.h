@@ -1,5 +1,7 @@
 #pragma once
 #include <glad/glad.h>
+#include <array>
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include "VertexBufferLayout.h"
@@ -13,30 +15,25 @@ struct VertexBase {
         : position(pos) {
     }
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout;
-        layout.Push<glm::vec3>(1);
-        return layout;
+    // In shader location order. Derived types append theirs to their parent's, see kVertexAttributes.
+    static constexpr auto GetAttributes() {
+        return std::array{MakeVertexAttribute<glm::vec3>(offsetof(VertexBase, position))};
     }
 };
 
 struct VertexNormal : public VertexBase {
     glm::vec3 normal;
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexBase::GenerateLayout();
-        layout.Push<glm::vec3>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexBase::GetAttributes(), MakeVertexAttribute<glm::vec3>(offsetof(VertexNormal, normal)));
     }
 };
 
 struct VertexNormalColor : public VertexNormal {
     glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f};
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexNormal::GenerateLayout();
-        layout.Push<glm::vec4>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexNormal::GetAttributes(), MakeVertexAttribute<glm::vec4>(offsetof(VertexNormalColor, color)));
     }
 };
 
@@ -54,20 +51,16 @@ struct VertexColor : public VertexBase {
           color(clr) {
     }
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexBase::GenerateLayout();
-        layout.Push<glm::vec4>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexBase::GetAttributes(), MakeVertexAttribute<glm::vec4>(offsetof(VertexColor, color)));
     }
 };
 
 struct VertexColorNormal : VertexColor {
     glm::vec3 normal;
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexColor::GenerateLayout();
-        layout.Push<glm::vec3>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexColor::GetAttributes(), MakeVertexAttribute<glm::vec3>(offsetof(VertexColorNormal, normal)));
     }
 };
 
@@ -75,24 +68,27 @@ struct VertexNormalTexture : public VertexBase {
     glm::vec3 normal;
     glm::vec2 texUV;
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexBase::GenerateLayout();
-        layout.Push<glm::vec3>(1);
-        layout.Push<glm::vec2>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexBase::GetAttributes(),
+            MakeVertexAttribute<glm::vec3>(offsetof(VertexNormalTexture, normal)),
+            MakeVertexAttribute<glm::vec2>(offsetof(VertexNormalTexture, texUV)));
     }
 };
 
 struct VertexColorNormalTexture : public VertexColorNormal {
     glm::vec2 texUV;
 
-    static VertexBufferLayout GenerateLayout() {
-        VertexBufferLayout layout = VertexColorNormal::GenerateLayout();
-        layout.Push<glm::vec2>(1);
-        return layout;
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexColorNormal::GetAttributes(),
+            MakeVertexAttribute<glm::vec2>(offsetof(VertexColorNormalTexture, texUV)));
     }
 };
 
+// Every byte of a vertex belongs to an attribute, in member order.
+static_assert(IsVertexLayoutPacked<VertexBase>() && IsVertexLayoutPacked<VertexNormal>() && IsVertexLayoutPacked<VertexNormalColor>()
+    && IsVertexLayoutPacked<VertexColor>() && IsVertexLayoutPacked<VertexColorNormal>() && IsVertexLayoutPacked<VertexNormalTexture>()
+    && IsVertexLayoutPacked<VertexColorNormalTexture>());
+
 template <class Vertex>
 class VertexBuffer {
 public:
@@ -106,6 +102,10 @@ public:
     VertexBuffer();
 
     void SetData(const std::vector<Vertex>& vertices);
+    // Allocate storage for vertexCount vertices without uploading any
+    void Allocate(size_t vertexCount);
+    // Overwrite count vertices starting at firstVertex inside the allocated storage
+    void SetSubData(size_t firstVertex, const Vertex* vertices, size_t count);
 
     void Bind() const;
     void UnBind() const;
@@ -125,6 +125,18 @@ void VertexBuffer<Vertex>::SetData(const std::vector<Vertex>& vertices) {
         vertices.data(), GL_DYNAMIC_DRAW);
 }
 
+template <class Vertex>
+void VertexBuffer<Vertex>::Allocate(size_t vertexCount) {
+    Bind();
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+}
+
+template <class Vertex>
+void VertexBuffer<Vertex>::SetSubData(size_t firstVertex, const Vertex* vertices, size_t count) {
+    Bind();
+    glBufferSubData(GL_ARRAY_BUFFER, firstVertex * sizeof(Vertex), count * sizeof(Vertex), vertices);
+}
+
 // Ctor that generates a Vertex Buffer Object and links it to vertices
 template <class Vertex>
 VertexBuffer<Vertex>::VertexBuffer(GLfloat* vertices, GLsizeiptr size) {
@@ -1,13 +1,16 @@
 #pragma once
 #include <glad/glad.h>
+#include <array>
+#include <cstddef>
 #include <vector>
+#include "glm/glm.hpp"
 
 struct VertexBufferElement {
   unsigned int count;
   unsigned int type;
   unsigned char normalized;
 
-  static unsigned int GetSize(unsigned int type) {
+  static constexpr unsigned int GetSize(unsigned int type) {
     switch (type) {
       case GL_FLOAT:
         return sizeof(GLfloat);
@@ -15,12 +18,97 @@ struct VertexBufferElement {
         return sizeof(GLuint);
       case GL_UNSIGNED_BYTE:
         return sizeof(GLbyte);
+      case GL_SHORT:
+        return sizeof(GLshort);
+      case GL_HALF_FLOAT:
+        return sizeof(GLhalf);
+      case GL_INT_2_10_10_10_REV:
+        return sizeof(GLuint);
     }
 
     return 0;
   }
+
+  // Packed types hold all components in one value of GetSize(type) bytes.
+  static constexpr bool IsPacked(unsigned int type) {
+    return type == GL_INT_2_10_10_10_REV;
+  }
+
+  constexpr unsigned int GetByteSize() const {
+    return IsPacked(type) ? GetSize(type) : count * GetSize(type);
+  }
 };  // struct VertexBufferElement
 
+// An attribute of a vertex type known at compile time: a VertexBufferElement
+// plus the byte offset of its member. Vertex types list theirs in a static
+// constexpr GetAttributes(), see kVertexAttributes.
+struct VertexAttribute {
+  VertexBufferElement element;
+  unsigned int offset;
+};
+
+// GL type and component count of a float vertex member of type T.
+template <typename T>
+struct VertexAttributeFormat;
+template <>
+struct VertexAttributeFormat<float> {
+  static constexpr unsigned int count = 1;
+};
+template <>
+struct VertexAttributeFormat<glm::vec2> {
+  static constexpr unsigned int count = 2;
+};
+template <>
+struct VertexAttributeFormat<glm::vec3> {
+  static constexpr unsigned int count = 3;
+};
+template <>
+struct VertexAttributeFormat<glm::vec4> {
+  static constexpr unsigned int count = 4;
+};
+
+// Attribute for a float or glm vector member of type T at offset.
+template <typename T>
+constexpr VertexAttribute MakeVertexAttribute(size_t offset) {
+  return {{VertexAttributeFormat<T>::count, GL_FLOAT, GL_FALSE},
+          static_cast<unsigned int>(offset)};
+}
+
+// The attributes of a parent vertex type followed by the ones a derived type
+// adds.
+template <size_t N, typename... Attributes>
+constexpr std::array<VertexAttribute, N + sizeof...(Attributes)>
+AppendVertexAttributes(const std::array<VertexAttribute, N>& parent,
+                       Attributes... attributes) {
+  std::array<VertexAttribute, N + sizeof...(Attributes)> result{};
+  for (size_t i = 0; i < N; i++) {
+    result[i] = parent[i];
+  }
+  const VertexAttribute added[] = {attributes...};
+  for (size_t i = 0; i < sizeof...(Attributes); i++) {
+    result[N + i] = added[i];
+  }
+  return result;
+}
+
+template <class Vertex>
+inline constexpr auto kVertexAttributes = Vertex::GetAttributes();
+
+// True if the attributes of Vertex cover it back to back in declaration
+// order, without gaps and up to sizeof(Vertex). A member whose type or order
+// disagrees with its attribute fails this check at compile time.
+template <class Vertex>
+constexpr bool IsVertexLayoutPacked() {
+  unsigned int offset = 0;
+  for (const VertexAttribute& attribute : kVertexAttributes<Vertex>) {
+    if (attribute.offset != offset) {
+      return false;
+    }
+    offset += attribute.element.GetByteSize();
+  }
+  return offset == sizeof(Vertex);
+}
+
 class VertexBufferLayout {
  private:
   std::vector<VertexBufferElement> m_Elements;
@@ -46,6 +134,15 @@ class VertexBufferLayout {
     m_Elements.push_back({count, GL_UNSIGNED_BYTE, GL_TRUE});
     m_Stride += VertexBufferElement::GetSize(GL_UNSIGNED_BYTE) * count;
   }
+  // An attribute of count components of a GL type, e.g. GL_SHORT normalized
+  // to [-1, 1] or the 4 components of GL_INT_2_10_10_10_REV.
+  void Push(unsigned int type, unsigned int count, bool bNormalized) {
+    const VertexBufferElement element{count, type,
+                                      static_cast<unsigned char>(
+                                          bNormalized ? GL_TRUE : GL_FALSE)};
+    m_Elements.push_back(element);
+    m_Stride += element.GetByteSize();
+  }
   template <>
   void Push<glm::vec3>(unsigned int count) {
     for (unsigned int i = 0; i < count; i++) {
@@ -65,6 +162,20 @@ class VertexBufferLayout {
     }
   }
 
+  // Runtime copy of the compile-time layout of Vertex, for code that edits
+  // layouts or describes them (GeometryCacheUtils).
+  template <class Vertex>
+  static VertexBufferLayout FromVertex() {
+    static_assert(IsVertexLayoutPacked<Vertex>(),
+                  "VertexBufferLayout has no gaps between attributes");
+    VertexBufferLayout layout;
+    for (const VertexAttribute& attribute : kVertexAttributes<Vertex>) {
+      layout.Push(attribute.element.type, attribute.element.count,
+                  attribute.element.normalized == GL_TRUE);
+    }
+    return layout;
+  }
+
   const std::vector<VertexBufferElement>& GetElements() const {
     return m_Elements;
   }
@@ -0,0 +1,279 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "glm/glm.hpp"
+
+/**
+ * Compressed counterparts of the vertex types in VertexBuffer.h, for meshes that are drawn but not edited:
+ * positions as 16-bit normalized integers within the mesh bounds, normals as 10:10:10:2 normalized integers,
+ * UVs as half floats and colors as RGBA8. The GPU expands all of them to floats on fetch, so a packed type uses the same
+ * attribute locations as its Source and works with the same shaders. The position decode (VertexQuantization) is an
+ * affine transform that goes into the model matrix, see Mesh::SetDecodeMatrix.
+ * Each type converts from its Source with Pack and back with Unpack; the packed sizes are 12 to 20 bytes against 24 to 48.
+ */
+
+/** Maps quantized positions in [-1, 1] back to model space: position = offset + scale * quantized. */
+struct VertexQuantization {
+    glm::vec3 offset{0.0f};
+    // One scale for all axes, so the decode matrix is a uniform scale and normals transform as before.
+    float scale = 1.0f;
+
+    glm::mat4 GetDecodeMatrix() const {
+        glm::mat4 decode(scale);
+        decode[3] = glm::vec4(offset, 1.0f);
+        return decode;
+    }
+
+    /** Centered on the bounding box of vertices, scaled to its largest half extent. */
+    template <class Vertex>
+    static VertexQuantization FromVertices(const std::vector<Vertex>& vertices) {
+        VertexQuantization quantization;
+        if (vertices.empty()) {
+            return quantization;
+        }
+        glm::vec3 min = vertices.front().position, max = min;
+        for (const auto& vertex : vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+        const glm::vec3 halfExtent = (max - min) * 0.5f;
+        quantization.offset = min + halfExtent;
+        quantization.scale = std::max({halfExtent.x, halfExtent.y, halfExtent.z});
+        if (quantization.scale <= 0.0f) {
+            quantization.scale = 1.0f;
+        }
+        return quantization;
+    }
+};
+
+namespace VertexPackingUtils {
+/** Round-to-nearest signed normalized integer of bits bits; GL decodes it as max(value / (2^(bits-1) - 1), -1). */
+inline int32_t QuantizeSnorm(float value, unsigned int bits) {
+    const float maxValue = static_cast<float>((1 << (bits - 1)) - 1);
+    return static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * maxValue));
+}
+
+inline float DequantizeSnorm(int32_t value, unsigned int bits) {
+    return std::max(static_cast<float>(value) / static_cast<float>((1 << (bits - 1)) - 1), -1.0f);
+}
+
+/** xyz as GL_INT_2_10_10_10_REV: x in the low 10 bits, w (unused, 0) in the top 2. */
+inline uint32_t PackSnorm10x3(const glm::vec3& value) {
+    return (static_cast<uint32_t>(QuantizeSnorm(value.x, 10)) & 0x3ffu)
+        | (static_cast<uint32_t>(QuantizeSnorm(value.y, 10)) & 0x3ffu) << 10
+        | (static_cast<uint32_t>(QuantizeSnorm(value.z, 10)) & 0x3ffu) << 20;
+}
+
+inline glm::vec3 UnpackSnorm10x3(uint32_t packed) {
+    // Shifting the field to the top and back sign-extends it.
+    auto component = [packed](unsigned int shift) {
+        return DequantizeSnorm(static_cast<int32_t>(packed << (22 - shift)) >> 22, 10);
+    };
+    return glm::vec3(component(0), component(10), component(20));
+}
+
+inline uint32_t PackUnorm8x4(const glm::vec4& value) {
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; i++) {
+        packed |= static_cast<uint32_t>(std::round(std::clamp(value[i], 0.0f, 1.0f) * 255.0f)) << (8 * i);
+    }
+    return packed;
+}
+
+inline glm::vec4 UnpackUnorm8x4(uint32_t packed) {
+    glm::vec4 value;
+    for (int i = 0; i < 4; i++) {
+        value[i] = static_cast<float>((packed >> (8 * i)) & 0xffu) / 255.0f;
+    }
+    return value;
+}
+} // namespace VertexPackingUtils
+
+struct VertexPackedBase {
+    using Source = VertexBase;
+
+    // x, y, z and padding, normalized to [-1, 1] by VertexQuantization. The attribute has 4 components so that the
+    // padding is covered; shaders read it as a vec3.
+    int16_t position[4] = {0, 0, 0, 0};
+
+    void Pack(const VertexBase& vertex, const VertexQuantization& quantization) {
+        const glm::vec3 normalized = (vertex.position - quantization.offset) / quantization.scale;
+        for (int i = 0; i < 3; i++) {
+            position[i] = static_cast<int16_t>(VertexPackingUtils::QuantizeSnorm(normalized[i], 16));
+        }
+    }
+
+    void Unpack(VertexBase& vertex, const VertexQuantization& quantization) const {
+        for (int i = 0; i < 3; i++) {
+            vertex.position[i] = quantization.offset[i] + quantization.scale * VertexPackingUtils::DequantizeSnorm(position[i], 16);
+        }
+    }
+
+    static constexpr auto GetAttributes() {
+        return std::array{VertexAttribute{{4, GL_SHORT, GL_TRUE}, offsetof(VertexPackedBase, position)}};
+    }
+};
+
+struct VertexPackedNormal : public VertexPackedBase {
+    using Source = VertexNormal;
+
+    uint32_t normal = 0;
+
+    void Pack(const VertexNormal& vertex, const VertexQuantization& quantization) {
+        VertexPackedBase::Pack(vertex, quantization);
+        normal = VertexPackingUtils::PackSnorm10x3(vertex.normal);
+    }
+
+    void Unpack(VertexNormal& vertex, const VertexQuantization& quantization) const {
+        VertexPackedBase::Unpack(vertex, quantization);
+        vertex.normal = VertexPackingUtils::UnpackSnorm10x3(normal);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedBase::GetAttributes(),
+            VertexAttribute{{4, GL_INT_2_10_10_10_REV, GL_TRUE}, offsetof(VertexPackedNormal, normal)});
+    }
+};
+
+struct VertexPackedNormalColor : public VertexPackedNormal {
+    using Source = VertexNormalColor;
+
+    uint32_t color = ~0u;
+
+    void Pack(const VertexNormalColor& vertex, const VertexQuantization& quantization) {
+        VertexPackedNormal::Pack(vertex, quantization);
+        color = VertexPackingUtils::PackUnorm8x4(vertex.color);
+    }
+
+    void Unpack(VertexNormalColor& vertex, const VertexQuantization& quantization) const {
+        VertexPackedNormal::Unpack(vertex, quantization);
+        vertex.color = VertexPackingUtils::UnpackUnorm8x4(color);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedNormal::GetAttributes(),
+            VertexAttribute{{4, GL_UNSIGNED_BYTE, GL_TRUE}, offsetof(VertexPackedNormalColor, color)});
+    }
+};
+
+struct VertexPackedColor : public VertexPackedBase {
+    using Source = VertexColor;
+
+    uint32_t color = ~0u;
+
+    void Pack(const VertexColor& vertex, const VertexQuantization& quantization) {
+        VertexPackedBase::Pack(vertex, quantization);
+        color = VertexPackingUtils::PackUnorm8x4(vertex.color);
+    }
+
+    void Unpack(VertexColor& vertex, const VertexQuantization& quantization) const {
+        VertexPackedBase::Unpack(vertex, quantization);
+        vertex.color = VertexPackingUtils::UnpackUnorm8x4(color);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedBase::GetAttributes(),
+            VertexAttribute{{4, GL_UNSIGNED_BYTE, GL_TRUE}, offsetof(VertexPackedColor, color)});
+    }
+};
+
+struct VertexPackedColorNormal : public VertexPackedColor {
+    using Source = VertexColorNormal;
+
+    uint32_t normal = 0;
+
+    void Pack(const VertexColorNormal& vertex, const VertexQuantization& quantization) {
+        VertexPackedColor::Pack(vertex, quantization);
+        normal = VertexPackingUtils::PackSnorm10x3(vertex.normal);
+    }
+
+    void Unpack(VertexColorNormal& vertex, const VertexQuantization& quantization) const {
+        VertexPackedColor::Unpack(vertex, quantization);
+        vertex.normal = VertexPackingUtils::UnpackSnorm10x3(normal);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedColor::GetAttributes(),
+            VertexAttribute{{4, GL_INT_2_10_10_10_REV, GL_TRUE}, offsetof(VertexPackedColorNormal, normal)});
+    }
+};
+
+struct VertexPackedNormalTexture : public VertexPackedNormal {
+    using Source = VertexNormalTexture;
+
+    // Two half floats.
+    uint32_t texUV = 0;
+
+    // VertexNormalTexture is not a VertexNormal, so the normal is packed here.
+    void Pack(const VertexNormalTexture& vertex, const VertexQuantization& quantization) {
+        VertexPackedBase::Pack(vertex, quantization);
+        normal = VertexPackingUtils::PackSnorm10x3(vertex.normal);
+        texUV = glm::packHalf2x16(vertex.texUV);
+    }
+
+    void Unpack(VertexNormalTexture& vertex, const VertexQuantization& quantization) const {
+        VertexPackedBase::Unpack(vertex, quantization);
+        vertex.normal = VertexPackingUtils::UnpackSnorm10x3(normal);
+        vertex.texUV = glm::unpackHalf2x16(texUV);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedNormal::GetAttributes(),
+            VertexAttribute{{2, GL_HALF_FLOAT, GL_FALSE}, offsetof(VertexPackedNormalTexture, texUV)});
+    }
+};
+
+struct VertexPackedColorNormalTexture : public VertexPackedColorNormal {
+    using Source = VertexColorNormalTexture;
+
+    // Two half floats.
+    uint32_t texUV = 0;
+
+    void Pack(const VertexColorNormalTexture& vertex, const VertexQuantization& quantization) {
+        VertexPackedColorNormal::Pack(vertex, quantization);
+        texUV = glm::packHalf2x16(vertex.texUV);
+    }
+
+    void Unpack(VertexColorNormalTexture& vertex, const VertexQuantization& quantization) const {
+        VertexPackedColorNormal::Unpack(vertex, quantization);
+        vertex.texUV = glm::unpackHalf2x16(texUV);
+    }
+
+    static constexpr auto GetAttributes() {
+        return AppendVertexAttributes(VertexPackedColorNormal::GetAttributes(),
+            VertexAttribute{{2, GL_HALF_FLOAT, GL_FALSE}, offsetof(VertexPackedColorNormalTexture, texUV)});
+    }
+};
+
+static_assert(IsVertexLayoutPacked<VertexPackedBase>() && IsVertexLayoutPacked<VertexPackedNormal>()
+    && IsVertexLayoutPacked<VertexPackedNormalColor>() && IsVertexLayoutPacked<VertexPackedColor>()
+    && IsVertexLayoutPacked<VertexPackedColorNormal>() && IsVertexLayoutPacked<VertexPackedNormalTexture>()
+    && IsVertexLayoutPacked<VertexPackedColorNormalTexture>());
+
+/** Convert vertices to PackedVertex with quantization, see VertexQuantization::FromVertices. */
+template <class PackedVertex>
+std::vector<PackedVertex> PackVertices(
+    const std::vector<typename PackedVertex::Source>& vertices, const VertexQuantization& quantization) {
+    std::vector<PackedVertex> packed(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        packed[i].Pack(vertices[i], quantization);
+    }
+    return packed;
+}
+
+template <class PackedVertex>
+std::vector<typename PackedVertex::Source> UnpackVertices(
+    const std::vector<PackedVertex>& packed, const VertexQuantization& quantization) {
+    std::vector<typename PackedVertex::Source> vertices(packed.size());
+    for (size_t i = 0; i < packed.size(); i++) {
+        packed[i].Unpack(vertices[i], quantization);
+    }
+    return vertices;
+}
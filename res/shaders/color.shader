@@ -5,13 +5,21 @@ layout(location = 1) in vec4 color;
 
 out vec4 v_Color;
 
+layout(location = 12) in mat4 a_InstanceModel;
+uniform bool u_Instanced;
 uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Proj;
+layout(std140) uniform Camera {
+	mat4 u_View;
+	mat4 u_Proj;
+	mat4 u_ViewProj;
+	vec4 u_CameraPosition;
+	vec4 u_Viewport;
+};
 void main()
 {
+	mat4 model = u_Instanced ? a_InstanceModel : u_Model;
 	v_Color = color;
-	gl_Position = u_Proj * u_View * u_Model * vec4(position, 1.0);
+	gl_Position = u_ViewProj * model * vec4(position, 1.0);
 };
 
 
@@ -2,18 +2,33 @@
 #version 330 core
 layout(location = 0) in vec3 position;
 
+layout(location = 12) in mat4 a_InstanceModel;
+uniform bool u_Instanced;
 uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Proj;
+layout(std140) uniform Camera {
+	mat4 u_View;
+	mat4 u_Proj;
+	mat4 u_ViewProj;
+	vec4 u_CameraPosition;
+	vec4 u_Viewport;
+};
 void main()
 {
-	gl_Position = u_Proj * u_View * u_Model * vec4(position, 1.0);
+	mat4 model = u_Instanced ? a_InstanceModel : u_Model;
+	gl_Position = u_ViewProj * model * vec4(position, 1.0);
 };
 
 
 #shader fragment
 #version 330 core
-uniform vec4 u_Color;
+layout(std140) uniform Material {
+	vec4 u_Color;
+	vec4 u_LineColor;
+	vec4 u_Ambient;
+	vec4 u_Diffuse;
+	vec4 u_Specular;
+	float u_LineWidth;
+};
 layout(location = 0) out vec4 color;
 
 void main()
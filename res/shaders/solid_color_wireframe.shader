@@ -2,21 +2,33 @@
 #version 330 core
 layout(location = 0) in vec3 position;
 
+layout(location = 12) in mat4 a_InstanceModel;
+uniform bool u_Instanced;
 uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Proj;
+layout(std140) uniform Camera {
+	mat4 u_View;
+	mat4 u_Proj;
+	mat4 u_ViewProj;
+	vec4 u_CameraPosition;
+	vec4 u_Viewport;
+};
 void main()
 {
-	gl_Position = u_Proj * u_View * u_Model * vec4(position, 1.0);
+	mat4 model = u_Instanced ? a_InstanceModel : u_Model;
+	gl_Position = u_ViewProj * model * vec4(position, 1.0);
 };
 
 #shader fragment
 #version 330 core
-uniform vec4 u_Color;
+layout(std140) uniform Material {
+	vec4 u_Color;
+	vec4 u_LineColor;
+	vec4 u_Ambient;
+	vec4 u_Diffuse;
+	vec4 u_Specular;
+	float u_LineWidth;
+};
 layout(location = 0) out vec4 FragColor;
-// The mesh line settings
-uniform float u_LineWidth;
-uniform vec4 u_LineColor;
 noperspective in vec3 GEdgeDistance;
 void main()
 {
@@ -41,8 +53,13 @@ void main()
 #version 330
 layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
-uniform int u_ScreenWidth;
-uniform int u_ScreenHeight;
+layout(std140) uniform Camera {
+	mat4 u_View;
+	mat4 u_Proj;
+	mat4 u_ViewProj;
+	vec4 u_CameraPosition;
+	vec4 u_Viewport;
+};
 noperspective out vec3 GEdgeDistance;
 void main() {
 	 //Transform to screen space
@@ -52,9 +69,9 @@ void main() {
 		gl_in[1].gl_Position.w));
 	vec3 p2 = vec3( (gl_in[2].gl_Position /
 		gl_in[2].gl_Position.w));
-	p0 = vec3((p0.x + 1.0) * u_ScreenWidth / 2.0, (p0.y + 1.0) * u_ScreenHeight / 2.0, p0.z);
-	p1 = vec3((p1.x + 1.0) * u_ScreenWidth / 2.0, (p1.y + 1.0) * u_ScreenHeight / 2.0, p1.z);
-	p2 = vec3((p2.x + 1.0) * u_ScreenWidth / 2.0, (p2.y + 1.0) * u_ScreenHeight / 2.0, p2.z);
+	p0 = vec3((p0.x + 1.0) * u_Viewport.x / 2.0, (p0.y + 1.0) * u_Viewport.y / 2.0, p0.z);
+	p1 = vec3((p1.x + 1.0) * u_Viewport.x / 2.0, (p1.y + 1.0) * u_Viewport.y / 2.0, p1.z);
+	p2 = vec3((p2.x + 1.0) * u_Viewport.x / 2.0, (p2.y + 1.0) * u_Viewport.y / 2.0, p2.z);
 
 	// Find the altitudes (ha, hb and hc)
 	float a = length(p1 - p2);
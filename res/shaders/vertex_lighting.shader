@@ -6,15 +6,23 @@ layout(location = 2) in vec4 color;
 
 out vec4 v_Color;
 
+layout(location = 12) in mat4 a_InstanceModel;
+uniform bool u_Instanced;
 uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Proj;
+layout(std140) uniform Camera {
+    mat4 u_View;
+    mat4 u_Proj;
+    mat4 u_ViewProj;
+    vec4 u_CameraPosition;
+    vec4 u_Viewport;
+};
 uniform vec3 u_LightPos;
 void main() {
-    mat4 MVMat = u_View * u_Model;
+    mat4 model = u_Instanced ? a_InstanceModel : u_Model;
+    mat4 MVMat = u_View * model;
     
     vec3 modelViewVertex = vec3(MVMat * vec4(position, 1.0));
-    vec3 modelViewNormal = vec3(MVMat * vec4(normal, 1.0));
+    vec3 modelViewNormal = normalize(mat3(MVMat) * normal);
     float distance = length(u_LightPos - modelViewVertex);
     vec3 lightDir = normalize(u_LightPos - modelViewVertex);
     float diffuse = max(dot(modelViewNormal, lightDir), 0.1) * (1.0 / (1.0 + (0.25 * distance * distance)));